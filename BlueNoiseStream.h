@@ -1,141 +1,385 @@
 #pragma once
 
-class BlueNoiseStreamPolynomial
+#include <algorithm>
+#include "SIMD.h"
+#include "RNGEngines.h"
+#include "FilteredNoiseStream.h"
+
+// ================= Polynomial streams =================
+// Uniform white noise through a 3 tap FIR filter, made uniform again with FilteredNoiseStreamT.
+// It's the same hand fit CDF for both.
+
+// 4 cubic polynomials, for x in [0,0.25), [0.25,0.5), [0.5,0.75) and [0.75,1]. Highest power first.
+#define NOISE_POLYNOMIAL_CDF() { \
+	5.25964f, 0.039474f, 0.000708779f, 0.0f, \
+	-5.20987f, 7.82905f, -1.93105f, 0.159677f, \
+	-5.22644f, 7.8272f, -1.91677f, 0.15507f, \
+	5.23882f, -15.761f, 15.8054f, -4.28323f \
+}
+
+// Filter uniform white noise to remove low frequencies and make it blue.
+struct BlueNoiseFilter
 {
-public:
-	BlueNoiseStreamPolynomial(pcg32_random_t rng)
-		: m_rng(rng)
+	static const int c_xTapCount = 3;
+	static const int c_yTapCount = 0;
+	static const float* XTaps() { static const float taps[c_xTapCount] = { 0.5f, -1.0f, 0.5f }; return taps; }
+	static const float* YTaps() { return nullptr; }
+	static const NoiseCDF& CDF() { static const NoiseCDF cdf = { 0.5f, 0.5f, 4, NOISE_POLYNOMIAL_CDF() }; return cdf; }
+};
+
+// Filter uniform white noise to remove high frequencies and make it red.
+struct RedNoiseFilter
+{
+	static const int c_xTapCount = 3;
+	static const int c_yTapCount = 0;
+	static const float* XTaps() { static const float taps[c_xTapCount] = { 0.25f, 0.5f, 0.25f }; return taps; }
+	static const float* YTaps() { return nullptr; }
+	static const NoiseCDF& CDF() { static const NoiseCDF cdf = { 1.0f, 0.0f, 4, NOISE_POLYNOMIAL_CDF() }; return cdf; }
+};
+
+// A steeper high pass: the 4th difference of the white noise, which takes more of the low frequencies out.
+struct BlueNoiseFilter5
+{
+	static const int c_xTapCount = 5;
+	static const int c_yTapCount = 0;
+	static const float* XTaps() { static const float taps[c_xTapCount] = { 0.0625f, -0.25f, 0.375f, -0.25f, 0.0625f }; return taps; }
+	static const float* YTaps() { return nullptr; }
+	static const NoiseCDF& CDF() { return FittedNoiseCDF<BlueNoiseFilter5>(); }
+};
+
+// A one pole low pass: y = (white noise + last y) / 2
+struct RedNoiseFilterIIR
+{
+	static const int c_xTapCount = 1;
+	static const int c_yTapCount = 1;
+	static const float* XTaps() { static const float taps[c_xTapCount] = { 0.5f }; return taps; }
+	static const float* YTaps() { static const float taps[c_yTapCount] = { 0.5f }; return taps; }
+	static const NoiseCDF& CDF() { return FittedNoiseCDF<RedNoiseFilterIIR>(); }
+};
+
+template <typename ENGINE, typename T = float, size_t CDF_TABLE_SIZE = 0>
+using BlueNoiseStreamPolynomialT = FilteredNoiseStreamT<ENGINE, BlueNoiseFilter, T, CDF_TABLE_SIZE>;
+
+template <typename ENGINE, typename T = float, size_t CDF_TABLE_SIZE = 0>
+using RedNoiseStreamPolynomialT = FilteredNoiseStreamT<ENGINE, RedNoiseFilter, T, CDF_TABLE_SIZE>;
+
+typedef BlueNoiseStreamPolynomialT<PCG32Engine> BlueNoiseStreamPolynomial;
+typedef RedNoiseStreamPolynomialT<PCG32Engine> RedNoiseStreamPolynomial;
+
+// ================= Appleton block kernels =================
+// Each Appleton sample is ret = bit/2 - p, where bit is +1 or -1, and then p = ret/2 for the next sample.
+// That's an affine map of p, but this is not a prefix scan of those maps: composing them doesn't give the same floats
+// as the scalar stream, which rounds every step. It's a heuristic instead, relying on the map halving any error in p,
+// and on two streams staying together once they land on the same float.
+// A block is split into one chunk per SIMD lane, and each lane starts from 0 on the last c_appletonWarmup bits of the chunk
+// before it, which is nearly always enough for it to land exactly where the real stream is. Lane 0 starts from the real p.
+// Afterwards each lane is checked against where the lane before it really ended, and the misses are redone in scalar,
+// so the output is always exact. The heuristic is only in how often that redo happens.
+// Starting from 0, a float stream caught up with the real one within 28 steps 94% of the time, and within 45 steps in all of 2 million tries.
+//
+// It's a modest win. On the dev box, with AVX2 or AVX-512, it made NextN() 1.25x to 1.4x faster with PCG32 or wyrand bits,
+// and 1.2x with the tiny PRNG bits. Next() is about 4.7 ns per sample, and NextN() without the scan is only 1.1x faster.
+// AppletonBenchmark shows all three for the machine it runs on.
+
+static const size_t c_appletonWarmup = 48;
+static const size_t c_appletonBlockSize = 2048;
+static const size_t c_appletonDiscardWarmup = 128;
+
+// The scalar stream, with the bits given as +/- 0.5. Returns the new p.
+template <typename T>
+T AppletonSteps(const T* halfBits, T* out, size_t count, T p)
+{
+	for (size_t i = 0; i < count; ++i)
 	{
-		m_lastValues[0] = RandomFloat01();
-		m_lastValues[1] = RandomFloat01();
+		T ret = halfBits[i] - p;
+		p = ret / 2.0f;
+		out[i] = ret * 0.5f + 0.5f;
 	}
-	
-	float Next()
+	return p;
+}
+
+// halfBitsT and outT are transposed: chunk k, step j is at [j * laneCount + k].
+// startP gets the p each lane started its chunk with, and endP gets the p it ended with.
+
+SIMD_TARGET_AVX2 inline void AppletonChunks_AVX2(const float* halfBitsT, float* outT, size_t chunkSize, float p, float* startP, float* endP)
+{
+	const __m256 halfV = _mm256_set1_ps(0.5f);
+	const __m256i previousLane = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+
+	__m256 pV = _mm256_setzero_ps();
+	for (size_t j = chunkSize - c_appletonWarmup; j < chunkSize; ++j)
 	{
-		// Filter uniform white noise to remove low frequencies and make it blue.
-		// A side effect is the noise becomes non uniform.
-		static const float xCoefficients[3] = {0.5f, -1.0f, 0.5f};
+		__m256 ret = _mm256_sub_ps(_mm256_permutevar8x32_ps(_mm256_loadu_ps(&halfBitsT[j * 8]), previousLane), pV);
+		pV = _mm256_mul_ps(ret, halfV);
+	}
+	pV = _mm256_blend_ps(pV, _mm256_set1_ps(p), 1);
+	_mm256_storeu_ps(startP, pV);
 
-		float value = RandomFloat01();
+	for (size_t j = 0; j < chunkSize; ++j)
+	{
+		__m256 ret = _mm256_sub_ps(_mm256_loadu_ps(&halfBitsT[j * 8]), pV);
+		pV = _mm256_mul_ps(ret, halfV);
+		_mm256_storeu_ps(&outT[j * 8], _mm256_add_ps(pV, halfV));
+	}
+	_mm256_storeu_ps(endP, pV);
+}
 
-		float y =
-			value * xCoefficients[0] +
-			m_lastValues[0] * xCoefficients[1] +
-			m_lastValues[1] * xCoefficients[2];
+SIMD_TARGET_AVX512 inline void AppletonChunks_AVX512(const float* halfBitsT, float* outT, size_t chunkSize, float p, float* startP, float* endP)
+{
+	const __m512 halfV = _mm512_set1_ps(0.5f);
+	const __m512i previousLane = _mm512_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14);
 
-		m_lastValues[1] = m_lastValues[0];
-		m_lastValues[0] = value;
+	__m512 pV = _mm512_setzero_ps();
+	for (size_t j = chunkSize - c_appletonWarmup; j < chunkSize; ++j)
+	{
+		__m512 ret = _mm512_sub_ps(_mm512_permutexvar_ps(previousLane, _mm512_loadu_ps(&halfBitsT[j * 16])), pV);
+		pV = _mm512_mul_ps(ret, halfV);
+	}
+	pV = _mm512_mask_blend_ps(1, pV, _mm512_set1_ps(p));
+	_mm512_storeu_ps(startP, pV);
 
-		// the noise is also [-1,1] now, normalize to [0,1]
-		float x = y * 0.5f + 0.5f;
+	for (size_t j = 0; j < chunkSize; ++j)
+	{
+		__m512 ret = _mm512_sub_ps(_mm512_loadu_ps(&halfBitsT[j * 16]), pV);
+		pV = _mm512_mul_ps(ret, halfV);
+		_mm512_storeu_ps(&outT[j * 16], _mm512_add_ps(pV, halfV));
+	}
+	_mm512_storeu_ps(endP, pV);
+}
 
-		// Make the noise uniform again by putting it through a piecewise cubic polynomial approximation of the CDF
-		// Switched to Horner's method polynomials, and a polynomial array to avoid branching, per Marc Reynolds. Thanks!
-		float polynomialCoefficients[16] = {
-			5.25964f, 0.039474f, 0.000708779f, 0.0f,
-			-5.20987f, 7.82905f, -1.93105f, 0.159677f,
-			-5.22644f, 7.8272f, -1.91677f, 0.15507f,
-			5.23882f, -15.761f, 15.8054f, -4.28323f
-		};
-		int first = std::min(int(x * 4.0f), 3) * 4;
-		return polynomialCoefficients[first + 3] + x * (polynomialCoefficients[first + 2] + x * (polynomialCoefficients[first + 1] + x * polynomialCoefficients[first + 0]));
+// Runs the Appleton stream over count bits, given as +/- 0.5, starting from p. Returns the new p.
+// count must be at most c_appletonBlockSize.
+inline float AppletonScan(const float* halfBits, float* out, size_t count, float p)
+{
+	size_t laneCount = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512: laneCount = 16; break;
+		case SIMDLevel::AVX2: laneCount = 8; break;
+		default: break;
 	}
 
-private:
-	float RandomFloat01()
+	// Only worth it when the chunks are a good bit longer than the warm up
+	size_t chunkSize = laneCount ? count / laneCount : 0;
+	size_t done = 0;
+	if (chunkSize >= c_appletonWarmup * 2)
 	{
-		// return a uniform white noise random float between 0 and 1.
-		// Can use whatever RNG you want, such as std::mt19937.
-		return ldexpf((float)pcg32_random_r(&m_rng), -32);
+		float halfBitsT[c_appletonBlockSize];
+		float outT[c_appletonBlockSize];
+		float startP[16];
+		float endP[16];
+
+		for (size_t k = 0; k < laneCount; ++k)
+			for (size_t j = 0; j < chunkSize; ++j)
+				halfBitsT[j * laneCount + k] = halfBits[k * chunkSize + j];
+
+		if (laneCount == 16)
+			AppletonChunks_AVX512(halfBitsT, outT, chunkSize, p, startP, endP);
+		else
+			AppletonChunks_AVX2(halfBitsT, outT, chunkSize, p, startP, endP);
+
+		for (size_t k = 0; k < laneCount; ++k)
+			for (size_t j = 0; j < chunkSize; ++j)
+				out[k * chunkSize + j] = outT[j * laneCount + k];
+
+		for (size_t k = 1; k < laneCount; ++k)
+		{
+			if (startP[k] != endP[k - 1])
+				endP[k] = AppletonSteps(&halfBits[k * chunkSize], &out[k * chunkSize], chunkSize, endP[k - 1]);
+		}
+
+		p = endP[laneCount - 1];
+		done = laneCount * chunkSize;
 	}
+	return AppletonSteps(&halfBits[done], &out[done], count - done, p);
+}
 
-	pcg32_random_t m_rng;
-	float m_lastValues[2] = {};
-};
+// There's no SIMD for doubles
+inline double AppletonScan(const double* halfBits, double* out, size_t count, double p)
+{
+	return AppletonSteps(halfBits, out, count, p);
+}
+
+// ================= Appleton random bits =================
+// BlueNoiseStreamAppletonT takes one random bit per sample, from one of these.
+// Next() returns one bit, and FillHalfBits() makes count of them as +/- 0.5, the same as count calls to Next() would.
+// The bits are random, so FillHalfBits() looks up the +/- 0.5 instead of branching on them.
 
-class RedNoiseStreamPolynomial
+static const float c_appletonHalfBits[2] = { -0.5f, 0.5f };
+
+// The super tiny PRNG from the links below. Only the top bit of the state is used, so each bit is a multiply, or and add,
+// and each one has to wait for the one before it.
+// There's no known way to jump it ahead, since the step isn't linear, so it has no Discard(), and a stream using it can't either.
+class AppletonTinyBits
 {
 public:
-	RedNoiseStreamPolynomial(pcg32_random_t rng)
-		: m_rng(rng)
+	AppletonTinyBits(unsigned int seed)
+		: m_seed(seed)
 	{
-		m_lastValues[0] = RandomFloat01();
-		m_lastValues[1] = RandomFloat01();
 	}
 
-	float Next()
+	bool Next()
 	{
-		// Filter uniform white noise to remove high frequencies and make it red.
-		// A side effect is the noise becomes non uniform.
-		static const float xCoefficients[3] = { 0.25f, 0.5f, 0.25f };
+		m_seed += (m_seed * m_seed) | 5;
+		return (m_seed & 0x80000000) != 0;
+	}
 
-		float value = RandomFloat01();
+	template <typename T>
+	void FillHalfBits(T* out, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			out[i] = c_appletonHalfBits[Next()];
+	}
+
+private:
+	unsigned int m_seed;
+};
+
+// All 64 bits of each NextU64() from ENGINE, lowest bit first. Bulk bits come from the engine's block fill.
+template <typename ENGINE>
+class AppletonEngineBits
+{
+public:
+	AppletonEngineBits(const ENGINE& engine)
+		: m_engine(engine)
+	{
+	}
 
-		float y =
-			value * xCoefficients[0] +
-			m_lastValues[0] * xCoefficients[1] +
-			m_lastValues[1] * xCoefficients[2];
+	bool Next()
+	{
+		if (m_bitsLeft == 0)
+		{
+			m_bits = m_engine.NextU64();
+			m_bitsLeft = 64;
+		}
+		bool bit = (m_bits & 1) != 0;
+		m_bits >>= 1;
+		m_bitsLeft--;
+		return bit;
+	}
 
-		m_lastValues[1] = m_lastValues[0];
-		m_lastValues[0] = value;
+	template <typename T>
+	void FillHalfBits(T* out, size_t count)
+	{
+		// Use up the bits left from Next(), then whole words straight from the engine, then start a new word for the rest
+		size_t done = 0;
+		for (; done < count && m_bitsLeft > 0; ++done)
+			out[done] = c_appletonHalfBits[Next()];
 
-		float x = y;
+		static const size_t c_wordBlockSize = 32;
+		uint64_t words[c_wordBlockSize];
+		while (count - done >= 64)
+		{
+			size_t wordCount = std::min((count - done) / 64, c_wordBlockSize);
+			m_engine.Fill(words, wordCount);
+			for (size_t wordIndex = 0; wordIndex < wordCount; ++wordIndex)
+			{
+				for (int bitIndex = 0; bitIndex < 64; ++bitIndex)
+					out[done + bitIndex] = c_appletonHalfBits[(words[wordIndex] >> bitIndex) & 1];
+				done += 64;
+			}
+		}
 
-		// Make the noise uniform again by putting it through a piecewise cubic polynomial approximation of the CDF
-		// Switched to Horner's method polynomials, and a polynomial array to avoid branching, per Marc Reynolds. Thanks!
-		float polynomialCoefficients[16] = {
-			5.25964f, 0.039474f, 0.000708779f, 0.0f,
-			-5.20987f, 7.82905f, -1.93105f, 0.159677f,
-			-5.22644f, 7.8272f, -1.91677f, 0.15507f,
-			5.23882f, -15.761f, 15.8054f, -4.28323f
-		};
-		int first = std::min(int(x * 4.0f), 3) * 4;
-		return polynomialCoefficients[first + 3] + x * (polynomialCoefficients[first + 2] + x * (polynomialCoefficients[first + 1] + x * polynomialCoefficients[first + 0]));
+		for (; done < count; ++done)
+			out[done] = c_appletonHalfBits[Next()];
 	}
 
-private:
-	float RandomFloat01()
+	void Discard(uint64_t count)
 	{
-		// return a uniform white noise random float between 0 and 1.
-		// Can use whatever RNG you want, such as std::mt19937.
-		return ldexpf((float)pcg32_random_r(&m_rng), -32);
+		uint64_t fromCurrent = std::min(count, (uint64_t)m_bitsLeft);
+		m_bits = (fromCurrent < 64) ? m_bits >> fromCurrent : 0;
+		m_bitsLeft -= (int)fromCurrent;
+		count -= fromCurrent;
+
+		m_engine.template Discard<uint64_t>(count / 64);
+		for (uint64_t i = 0; i < count % 64; ++i)
+			Next();
 	}
 
-	pcg32_random_t m_rng;
-	float m_lastValues[2] = {};
+private:
+	ENGINE m_engine;
+	uint64_t m_bits = 0;
+	int m_bitsLeft = 0;
 };
 
+// ================= Appleton stream =================
+
 // From Nick Appleton:
 // https://mastodon.gamedev.place/@nickappleton/110009300197779505
 // But I'm using this for the single bit random value needed per number:
 // https://blog.demofox.org/2013/07/07/a-super-tiny-random-number-generator/
 // Which comes from:
 // http://www.woodmann.com/forum/showthread.php?3100-super-tiny-PRNG
-class BlueNoiseStreamAppleton
+//
+// T is float, or double for more bits of precision.
+// BITS is where the random bits come from: AppletonTinyBits, which is the original, or AppletonEngineBits.
+template <typename T, typename BITS = AppletonTinyBits>
+class BlueNoiseStreamAppletonT
 {
 public:
-	BlueNoiseStreamAppleton(unsigned int seed)
-		: m_seed(seed)
+	BlueNoiseStreamAppletonT(const BITS& bits)
+		: m_bits(bits)
 		, m_p(0.0f)
 	{
 	}
 
-	float Next()
+	T Next()
 	{
-		float ret = (GenerateRandomBit() ? 1.0f : -1.0f) / 2.0f - m_p;
+		T ret = c_appletonHalfBits[m_bits.Next()] - m_p;
 		m_p = ret / 2.0f;
 
 		// convert from [-1,1] to [0,1]
 		return ret * 0.5f + 0.5f;
 	}
 
-private:
-	bool GenerateRandomBit()
+	// Same as calling Next() count times.
+	// The random bits are made a block at a time, and then the whole block is done at once by AppletonScan().
+	void NextN(T* out, size_t count)
 	{
-		m_seed += (m_seed * m_seed) | 5;
-		return (m_seed & 0x80000000) != 0;
+		T halfBits[c_appletonBlockSize];
+		for (size_t done = 0; done < count; done += c_appletonBlockSize)
+		{
+			size_t blockCount = std::min(count - done, c_appletonBlockSize);
+			m_bits.FillHalfBits(halfBits, blockCount);
+			m_p = AppletonScan(halfBits, &out[done], blockCount, m_p);
+		}
 	}
 
-	unsigned int m_seed;
-	float m_p;
+	// Same as calling Next() count times. BITS needs a Discard(), so this is for AppletonEngineBits.
+	// The bits are jumped to a warm up before the target, and p is rebuilt from there. The step from p to the next p,
+	// (halfBit - p) / 2, is rounded, but is monotone (decreasing), and every p is in [-0.5, 0.5]. So the real p stays
+	// between the two bounding streams, started from -0.5 and 0.5, which swap which one is lower every step. Once those
+	// two meet, the real p is where they are.
+	// If they haven't met by the target, the warm up is doubled. In 2 million tries, from 0, floats always met the real
+	// stream within 45 samples and doubles within 75, so c_appletonDiscardWarmup is nearly always enough.
+	void Discard(uint64_t count)
+	{
+		for (uint64_t warmup = c_appletonDiscardWarmup; warmup < count; warmup *= 2)
+		{
+			BITS bits = m_bits;
+			bits.Discard(count - warmup);
+			T low = -0.5f;
+			T high = 0.5f;
+			for (uint64_t i = 0; i < warmup; ++i)
+			{
+				T halfBit = c_appletonHalfBits[bits.Next()];
+				low = (halfBit - low) / 2.0f;
+				high = (halfBit - high) / 2.0f;
+			}
+			if (low == high)
+			{
+				m_bits = bits;
+				m_p = low;
+				return;
+			}
+		}
+		for (uint64_t i = 0; i < count; ++i)
+			Next();
+	}
+
+private:
+	BITS m_bits;
+	T m_p;
 };
+
+typedef BlueNoiseStreamAppletonT<float> BlueNoiseStreamAppleton;
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "SIMD.h"
+
+// Maps random numbers to one of numBuckets integer buckets.
+//
+// Raw 32 bit rng output uses Lemire's multiply-shift: (x * numBuckets) >> 32.
+// That has no division, and the bias is at most numBuckets / 2^32, same as a float mapping would have.
+//
+// Floats in [0,1] are mapped as floor(f * numBuckets), exactly, for any 32 bit numBuckets.
+// Doing it in double isn't enough: a 24 bit mantissa times a 32 bit integer is 56 bits, so double is only exact below
+// 2^29 buckets. Instead, f is its mantissa times 2^-shift, so the product is the 56 bit integer mantissa * numBuckets,
+// shifted down, which is exact in 64 bit integers. An f of exactly 1.0 is clamped into the last bucket.
+//
+// Past 2^32 buckets, or when floats don't have enough bits, there are 64 bit versions:
+// Raw 64 bit rng output uses the same multiply-shift, with the high 64 bits of the 128 bit product.
+// Doubles in [0,1] are mapped as floor(d * numBuckets). That product can round, so for a very few
+// values just under a bucket boundary it picks the next bucket up, which is a bias of at most numBuckets / 2^53.
+
+inline uint32_t BucketFromU32(uint32_t x, uint32_t numBuckets)
+{
+	return (uint32_t)(((uint64_t)x * (uint64_t)numBuckets) >> 32);
+}
+
+// Denormals, zero, and negative floats have a shift of 64 or more (or wrap around to one), and go to bucket 0
+inline uint32_t BucketFromFloat01(float f, uint32_t numBuckets)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	uint64_t mantissa = (bits & 0x7FFFFF) | 0x800000;
+	uint32_t shift = 150 - (bits >> 23);
+	uint64_t bucket = shift < 64 ? (mantissa * numBuckets) >> shift : 0;
+	return bucket < numBuckets ? (uint32_t)bucket : numBuckets - 1;
+}
+
+inline uint64_t BucketFromU64(uint64_t x, uint64_t numBuckets)
+{
+	uint64_t lo, hi;
+	Mul128(x, numBuckets, lo, hi);
+	return hi;
+}
+
+inline uint64_t BucketFromDouble01(double d, uint64_t numBuckets)
+{
+	uint64_t bucket = (uint64_t)(d * double(numBuckets));
+	return bucket < numBuckets ? bucket : numBuckets - 1;
+}
+
+// ================= AVX2 =================
+
+SIMD_TARGET_AVX2 inline size_t U32ToBuckets_AVX2(const uint32_t* in, uint32_t* out, size_t count, uint32_t numBuckets)
+{
+	const __m256i bucketsV = _mm256_set1_epi64x(numBuckets);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// mul_epu32 only uses the even 32 bit lanes, so do the evens and odds separately and take the high halves
+		__m256i x = _mm256_loadu_si256((const __m256i*)&in[i]);
+		__m256i even = _mm256_srli_epi64(_mm256_mul_epu32(x, bucketsV), 32);
+		__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), bucketsV);
+		_mm256_storeu_si256((__m256i*)&out[i], _mm256_blend_epi32(even, odd, 0xAA));
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX2 inline size_t Float01ToBuckets_AVX2(const float* in, uint32_t* out, size_t count, uint32_t numBuckets)
+{
+	const __m256i bucketsV = _mm256_set1_epi64x(numBuckets);
+	const __m256i lastBucketV = _mm256_set1_epi64x(numBuckets - 1);
+	const __m256i mantissaMaskV = _mm256_set1_epi32(0x7FFFFF);
+	const __m256i implicitBitV = _mm256_set1_epi32(0x800000);
+	const __m256i shiftBiasV = _mm256_set1_epi32(150);
+	const __m256i lowMaskV = _mm256_set1_epi64x(0xFFFFFFFF);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// Same as BucketFromFloat01, for any float. srlv gives 0 for shifts of 64 or more, and the evens' shifts are zero
+		// extended to 64 bits. Floats over 1 can make buckets past 32 bits, so they are clamped before packing. They are under
+		// 2^56, so a signed compare will do, since AVX2 has no unsigned 64 bit min.
+		__m256i x = _mm256_loadu_si256((const __m256i*)&in[i]);
+		__m256i mantissa = _mm256_or_si256(_mm256_and_si256(x, mantissaMaskV), implicitBitV);
+		__m256i shift = _mm256_sub_epi32(shiftBiasV, _mm256_srli_epi32(x, 23));
+		__m256i even = _mm256_srlv_epi64(_mm256_mul_epu32(mantissa, bucketsV), _mm256_and_si256(shift, lowMaskV));
+		__m256i odd = _mm256_srlv_epi64(_mm256_mul_epu32(_mm256_srli_epi64(mantissa, 32), bucketsV), _mm256_srli_epi64(shift, 32));
+		even = _mm256_blendv_epi8(even, lastBucketV, _mm256_cmpgt_epi64(even, lastBucketV));
+		odd = _mm256_blendv_epi8(odd, lastBucketV, _mm256_cmpgt_epi64(odd, lastBucketV));
+		_mm256_storeu_si256((__m256i*)&out[i], _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA));
+	}
+	return i;
+}
+
+// The SIMD FindBucket kernels return the index of the first match, or count if there isn't one in the whole blocks.
+// searched is set to how many were checked, so the caller can check the rest.
+SIMD_TARGET_AVX2 inline size_t FindBucket_AVX2(const uint32_t* buckets, size_t count, uint32_t bucket, size_t& searched)
+{
+	const __m256i bucketV = _mm256_set1_epi32((int)bucket);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)&buckets[i]), bucketV)));
+		if (mask != 0)
+		{
+			searched = i;
+			return i + CountTrailingZeros((uint32_t)mask);
+		}
+	}
+	searched = i;
+	return count;
+}
+
+SIMD_TARGET_AVX2 inline size_t FindBucket_AVX2(const uint64_t* buckets, size_t count, uint64_t bucket, size_t& searched)
+{
+	const __m256i bucketV = _mm256_set1_epi64x((long long)bucket);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)&buckets[i]), bucketV)));
+		if (mask != 0)
+		{
+			searched = i;
+			return i + CountTrailingZeros((uint32_t)mask);
+		}
+	}
+	searched = i;
+	return count;
+}
+
+// ================= AVX-512 =================
+
+SIMD_TARGET_AVX512 inline size_t U32ToBuckets_AVX512(const uint32_t* in, uint32_t* out, size_t count, uint32_t numBuckets)
+{
+	const __m512i bucketsV = _mm512_set1_epi64(numBuckets);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m512i x = _mm512_loadu_si512((const void*)&in[i]);
+		__m512i even = _mm512_srli_epi64(_mm512_mul_epu32(x, bucketsV), 32);
+		__m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(x, 32), bucketsV);
+		_mm512_storeu_si512((void*)&out[i], _mm512_mask_blend_epi32(0xAAAA, even, odd));
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX512 inline size_t Float01ToBuckets_AVX512(const float* in, uint32_t* out, size_t count, uint32_t numBuckets)
+{
+	const __m512i bucketsV = _mm512_set1_epi64(numBuckets);
+	const __m512i lastBucketV = _mm512_set1_epi64(numBuckets - 1);
+	const __m512i mantissaMaskV = _mm512_set1_epi32(0x7FFFFF);
+	const __m512i implicitBitV = _mm512_set1_epi32(0x800000);
+	const __m512i shiftBiasV = _mm512_set1_epi32(150);
+	const __m512i lowMaskV = _mm512_set1_epi64(0xFFFFFFFF);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m512i x = _mm512_loadu_si512((const void*)&in[i]);
+		__m512i mantissa = _mm512_or_si512(_mm512_and_si512(x, mantissaMaskV), implicitBitV);
+		__m512i shift = _mm512_sub_epi32(shiftBiasV, _mm512_srli_epi32(x, 23));
+		__m512i even = _mm512_srlv_epi64(_mm512_mul_epu32(mantissa, bucketsV), _mm512_and_si512(shift, lowMaskV));
+		__m512i odd = _mm512_srlv_epi64(_mm512_mul_epu32(_mm512_srli_epi64(mantissa, 32), bucketsV), _mm512_srli_epi64(shift, 32));
+		even = _mm512_min_epu64(even, lastBucketV);
+		odd = _mm512_min_epu64(odd, lastBucketV);
+		_mm512_storeu_si512((void*)&out[i], _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32)));
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX512 inline size_t FindBucket_AVX512(const uint32_t* buckets, size_t count, uint32_t bucket, size_t& searched)
+{
+	const __m512i bucketV = _mm512_set1_epi32((int)bucket);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void*)&buckets[i]), bucketV);
+		if (mask != 0)
+		{
+			searched = i;
+			return i + CountTrailingZeros((uint32_t)mask);
+		}
+	}
+	searched = i;
+	return count;
+}
+
+// AVX2 has no double to 64 bit integer conversion, so only AVX-512 gets a 64 bit version of this
+SIMD_TARGET_AVX512 inline size_t Double01ToBuckets_AVX512(const double* in, uint64_t* out, size_t count, uint64_t numBuckets)
+{
+	const __m512d bucketsV = _mm512_set1_pd(double(numBuckets));
+	const __m512i lastBucketV = _mm512_set1_epi64((long long)(numBuckets - 1));
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m512i buckets = _mm512_cvttpd_epu64(_mm512_mul_pd(_mm512_loadu_pd(&in[i]), bucketsV));
+		_mm512_storeu_si512((void*)&out[i], _mm512_min_epu64(buckets, lastBucketV));
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX512 inline size_t FindBucket_AVX512(const uint64_t* buckets, size_t count, uint64_t bucket, size_t& searched)
+{
+	const __m512i bucketV = _mm512_set1_epi64((long long)bucket);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__mmask8 mask = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512((const void*)&buckets[i]), bucketV);
+		if (mask != 0)
+		{
+			searched = i;
+			return i + CountTrailingZeros((uint32_t)mask);
+		}
+	}
+	searched = i;
+	return count;
+}
+
+// ================= Dispatch =================
+
+// Maps count raw rng values to buckets
+inline void U32ToBuckets(const uint32_t* in, uint32_t* out, size_t count, uint32_t numBuckets)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512: done = U32ToBuckets_AVX512(in, out, count, numBuckets); break;
+		case SIMDLevel::AVX2: done = U32ToBuckets_AVX2(in, out, count, numBuckets); break;
+		default: break;
+	}
+	for (size_t i = done; i < count; ++i)
+		out[i] = BucketFromU32(in[i], numBuckets);
+}
+
+// Maps count [0,1] floats to buckets.
+inline void Float01ToBuckets(const float* in, uint32_t* out, size_t count, uint32_t numBuckets)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512: done = Float01ToBuckets_AVX512(in, out, count, numBuckets); break;
+		case SIMDLevel::AVX2: done = Float01ToBuckets_AVX2(in, out, count, numBuckets); break;
+		default: break;
+	}
+	for (size_t i = done; i < count; ++i)
+		out[i] = BucketFromFloat01(in[i], numBuckets);
+}
+
+// Maps count raw 64 bit rng values to buckets.
+// There is no SIMD for this, since neither AVX2 nor AVX-512 have a 64x64 to 128 bit multiply.
+inline void U64ToBuckets(const uint64_t* in, uint64_t* out, size_t count, uint64_t numBuckets)
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = BucketFromU64(in[i], numBuckets);
+}
+
+// Maps count [0,1] doubles to buckets. numBuckets must be less than 2^53.
+inline void Double01ToBuckets(const double* in, uint64_t* out, size_t count, uint64_t numBuckets)
+{
+	size_t done = 0;
+	if (ActiveSIMDLevel() == SIMDLevel::AVX512)
+		done = Double01ToBuckets_AVX512(in, out, count, numBuckets);
+	for (size_t i = done; i < count; ++i)
+		out[i] = BucketFromDouble01(in[i], numBuckets);
+}
+
+// Returns the index of the first bucket equal to bucket, or count if there isn't one.
+// The SIMD paths compare a whole block at a time, and only look for the exact index in a block that matched.
+// BUCKET is uint32_t or uint64_t.
+template <typename BUCKET>
+size_t FindBucket(const BUCKET* buckets, size_t count, BUCKET bucket)
+{
+	size_t searched = 0;
+	size_t found = count;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512: found = FindBucket_AVX512(buckets, count, bucket, searched); break;
+		case SIMDLevel::AVX2: found = FindBucket_AVX2(buckets, count, bucket, searched); break;
+		default: break;
+	}
+	if (found != count)
+		return found;
+	for (size_t i = searched; i < count; ++i)
+	{
+		if (buckets[i] == bucket)
+			return i;
+	}
+	return count;
+}
+
+// Which of numBuckets buckets have been hit, a bit per bucket.
+// Covered() is a popcount per 64 buckets, so it's cheap to ask, even for a lot of buckets.
+class BucketCoverage
+{
+public:
+	explicit BucketCoverage(size_t numBuckets)
+		: m_bits((numBuckets + 63) / 64, 0)
+	{
+	}
+
+	void Clear()
+	{
+		std::fill(m_bits.begin(), m_bits.end(), 0);
+	}
+
+	// BUCKET is uint32_t or uint64_t, and each has to be less than numBuckets
+	template <typename BUCKET>
+	void Add(const BUCKET* buckets, size_t count)
+	{
+		uint64_t* bits = m_bits.data();
+		for (size_t i = 0; i < count; ++i)
+			bits[buckets[i] / 64] |= uint64_t(1) << (buckets[i] % 64);
+	}
+
+	// Same as Add, and also counts when each bucket was first hit: firstHits[firstIndex + i] goes up by one if buckets[i]
+	// wasn't covered yet. firstIndex is how many tickets came before these. Summing firstHits up to k gives how many buckets
+	// the first k tickets cover, for every k, from one pass.
+	template <typename BUCKET>
+	void AddFirstHits(const BUCKET* buckets, size_t count, size_t firstIndex, uint64_t* firstHits)
+	{
+		uint64_t* bits = m_bits.data();
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint64_t& word = bits[buckets[i] / 64];
+			uint64_t bit = uint64_t(1) << (buckets[i] % 64);
+			firstHits[firstIndex + i] += (word & bit) ? 0 : 1;
+			word |= bit;
+		}
+	}
+
+	size_t Covered() const
+	{
+		size_t covered = 0;
+		for (uint64_t word : m_bits)
+			covered += PopCount64(word);
+		return covered;
+	}
+
+private:
+	std::vector<uint64_t> m_bits;
+};
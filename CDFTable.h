@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stddef.h>
+#include <algorithm>
+#include "SIMD.h"
+
+// A function on [0,1], usually a CDF to make a non uniform distribution uniform, sampled at SIZE + 1 evenly spaced points
+// and linearly interpolated. That's a lookup and a multiply add per sample, instead of branches or a polynomial.
+// values[i] is the function at i / SIZE, and slopes[i] is values[i + 1] - values[i]. slopes[SIZE] is 0, so x = 1 is no special case.
+//
+// The constructor is constexpr, so a table of a constexpr function can be made at compile time.
+// FUNCTION is anything callable with a double, which has to be constexpr for that.
+// Compilers limit how much work a constant expression can do. gcc's defaults allow 65536 entries. MSVC's don't,
+// so EulerProbability.vcxproj raises them with /constexpr:steps. For clang, use -fconstexpr-steps.
+template <size_t SIZE>
+struct CDFTable
+{
+	template <typename FUNCTION>
+	constexpr explicit CDFTable(const FUNCTION& function)
+		: values{}
+		, slopes{}
+	{
+		for (size_t i = 0; i <= SIZE; ++i)
+			values[i] = float(function(double(i) / double(SIZE)));
+		for (size_t i = 0; i < SIZE; ++i)
+			slopes[i] = values[i + 1] - values[i];
+	}
+
+	float values[SIZE + 1];
+	float slopes[SIZE + 1];
+};
+
+template <size_t SIZE, typename T>
+T EvaluateCDFTable(const CDFTable<SIZE>& table, T x)
+{
+	T position = x * float(SIZE);
+	int index = std::min(std::max(int(position), 0), int(SIZE));
+	return MulThenAdd(T(table.slopes[index]), position - T(index), T(table.values[index]));
+}
+
+// ================= SIMD =================
+// These give the same bits as the scalar version.
+
+template <size_t SIZE>
+SIMD_TARGET_AVX2 __m256 EvaluateCDFTable_AVX2(const CDFTable<SIZE>& table, __m256 x)
+{
+	__m256 position = _mm256_mul_ps(x, _mm256_set1_ps(float(SIZE)));
+	__m256i index = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvttps_epi32(position), _mm256_setzero_si256()), _mm256_set1_epi32(int(SIZE)));
+	__m256 fraction = _mm256_sub_ps(position, _mm256_cvtepi32_ps(index));
+	__m256 value = _mm256_i32gather_ps(table.values, index, 4);
+	__m256 slope = _mm256_i32gather_ps(table.slopes, index, 4);
+	return _mm256_add_ps(value, _mm256_mul_ps(slope, fraction));
+}
+
+template <size_t SIZE>
+SIMD_TARGET_AVX512 __m512 EvaluateCDFTable_AVX512(const CDFTable<SIZE>& table, __m512 x)
+{
+	// Masked gathers, with a zero source, because gcc warns that the unmasked ones read an uninitialized register
+	__m512 position = _mm512_mul_ps(x, _mm512_set1_ps(float(SIZE)));
+	__m512i index = _mm512_min_epi32(_mm512_max_epi32(_mm512_cvttps_epi32(position), _mm512_setzero_si512()), _mm512_set1_epi32(int(SIZE)));
+	__m512 fraction = _mm512_sub_ps(position, _mm512_cvtepi32_ps(index));
+	__m512 value = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, index, table.values, 4);
+	__m512 slope = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, index, table.slopes, 4);
+	return _mm512_add_ps(value, _mm512_mul_ps(slope, fraction));
+}
+
+template <size_t SIZE>
+SIMD_TARGET_AVX2 void EvaluateCDFTable_AVX2(const CDFTable<SIZE>& table, const float* in, float* out, size_t blockCount)
+{
+	for (size_t block = 0; block < blockCount; ++block)
+		_mm256_storeu_ps(&out[block * 8], EvaluateCDFTable_AVX2(table, _mm256_loadu_ps(&in[block * 8])));
+}
+
+template <size_t SIZE>
+SIMD_TARGET_AVX512 void EvaluateCDFTable_AVX512(const CDFTable<SIZE>& table, const float* in, float* out, size_t blockCount)
+{
+	for (size_t block = 0; block < blockCount; ++block)
+		_mm512_storeu_ps(&out[block * 16], EvaluateCDFTable_AVX512(table, _mm512_loadu_ps(&in[block * 16])));
+}
+
+// in and out can be the same
+template <size_t SIZE>
+void EvaluateCDFTable(const CDFTable<SIZE>& table, const float* in, float* out, size_t count)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512:
+		{
+			size_t blockCount = count / 16;
+			if (blockCount > 0)
+				EvaluateCDFTable_AVX512(table, in, out, blockCount);
+			done = blockCount * 16;
+			break;
+		}
+		case SIMDLevel::AVX2:
+		{
+			size_t blockCount = count / 8;
+			if (blockCount > 0)
+				EvaluateCDFTable_AVX2(table, in, out, blockCount);
+			done = blockCount * 8;
+			break;
+		}
+		default: break;
+	}
+	for (size_t i = done; i < count; ++i)
+		out[i] = EvaluateCDFTable(table, in[i]);
+}
+
+// There's no SIMD for doubles
+template <size_t SIZE>
+void EvaluateCDFTable(const CDFTable<SIZE>& table, const double* in, double* out, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = EvaluateCDFTable(table, in[i]);
+}
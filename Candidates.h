@@ -0,0 +1,314 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "SIMD.h"
+
+// The secretary problem: candidates are seen one at a time, and the one taken is the first that is better than every one of
+// the first cutoff of them. How good a choice that was is how many of all of the candidates are better than it.
+//
+// That's three searches: the best before the cutoff, the first after it that beats that, and how many beat the one taken.
+// The one taken beats everything before it, so only the ones after it can be better, and the three searches can be done
+// one after the other in a single pass. Each candidate is looked at once, as it comes, so they don't need to be stored.
+
+// ================= AVX2 =================
+// The SIMD kernels do whole blocks of 8 or 16, and return how many they did. The dispatch does the rest.
+
+SIMD_TARGET_AVX2 inline float MaxLanes_AVX2(__m256 x)
+{
+	__m128 x4 = _mm_max_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+	x4 = _mm_max_ps(x4, _mm_movehl_ps(x4, x4));
+	x4 = _mm_max_ss(x4, _mm_shuffle_ps(x4, x4, 1));
+	return _mm_cvtss_f32(x4);
+}
+
+SIMD_TARGET_AVX2 inline uint32_t SumLanes_AVX2(__m256i x)
+{
+	__m128i x4 = _mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+	x4 = _mm_add_epi32(x4, _mm_shuffle_epi32(x4, _MM_SHUFFLE(1, 0, 3, 2)));
+	x4 = _mm_add_epi32(x4, _mm_shuffle_epi32(x4, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (uint32_t)_mm_cvtsi128_si32(x4);
+}
+
+SIMD_TARGET_AVX2 inline size_t MaxCandidate_AVX2(const float* candidates, size_t count, float& best)
+{
+	__m256 bestV = _mm256_set1_ps(best);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		bestV = _mm256_max_ps(bestV, _mm256_loadu_ps(&candidates[i]));
+	best = MaxLanes_AVX2(bestV);
+	return i;
+}
+
+// Returns the index of the first candidate better than threshold, or count if there isn't one in the whole blocks
+SIMD_TARGET_AVX2 inline size_t FindBetterCandidate_AVX2(const float* candidates, size_t count, float threshold, size_t& searched)
+{
+	const __m256 thresholdV = _mm256_set1_ps(threshold);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(&candidates[i]), thresholdV, _CMP_GT_OQ));
+		if (mask != 0)
+		{
+			searched = i;
+			return i + CountTrailingZeros((uint32_t)mask);
+		}
+	}
+	searched = i;
+	return count;
+}
+
+// The compare gives -1 in each lane that's better, so subtracting it counts them
+SIMD_TARGET_AVX2 inline size_t CountBetterCandidates_AVX2(const float* candidates, size_t count, float threshold, size_t& betterCount)
+{
+	const __m256 thresholdV = _mm256_set1_ps(threshold);
+	__m256i countV = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		countV = _mm256_sub_epi32(countV, _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(&candidates[i]), thresholdV, _CMP_GT_OQ)));
+	betterCount = SumLanes_AVX2(countV);
+	return i;
+}
+
+// ================= AVX-512 =================
+// The halves are taken with masked extracts, because gcc warns that the unmasked ones, the casts to 256 bits and the
+// _mm512_reduce ones read an uninitialized register.
+
+SIMD_TARGET_AVX512 inline size_t MaxCandidate_AVX512(const float* candidates, size_t count, float& best)
+{
+	__m512 bestV = _mm512_set1_ps(best);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+		bestV = _mm512_max_ps(bestV, _mm512_loadu_ps(&candidates[i]));
+	__m256 low = _mm512_mask_extractf32x8_ps(_mm256_setzero_ps(), 0xFF, bestV, 0);
+	__m256 high = _mm512_mask_extractf32x8_ps(_mm256_setzero_ps(), 0xFF, bestV, 1);
+	best = MaxLanes_AVX2(_mm256_max_ps(low, high));
+	return i;
+}
+
+SIMD_TARGET_AVX512 inline size_t FindBetterCandidate_AVX512(const float* candidates, size_t count, float threshold, size_t& searched)
+{
+	const __m512 thresholdV = _mm512_set1_ps(threshold);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__mmask16 mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(&candidates[i]), thresholdV, _CMP_GT_OQ);
+		if (mask != 0)
+		{
+			searched = i;
+			return i + CountTrailingZeros((uint32_t)mask);
+		}
+	}
+	searched = i;
+	return count;
+}
+
+SIMD_TARGET_AVX512 inline size_t CountBetterCandidates_AVX512(const float* candidates, size_t count, float threshold, size_t& betterCount)
+{
+	const __m512 thresholdV = _mm512_set1_ps(threshold);
+	const __m512i oneV = _mm512_set1_epi32(1);
+	__m512i countV = _mm512_setzero_si512();
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__mmask16 mask = _mm512_cmp_ps_mask(_mm512_loadu_ps(&candidates[i]), thresholdV, _CMP_GT_OQ);
+		countV = _mm512_mask_add_epi32(countV, mask, countV, oneV);
+	}
+	__m256i low = _mm512_mask_extracti32x8_epi32(_mm256_setzero_si256(), 0xFF, countV, 0);
+	__m256i high = _mm512_mask_extracti32x8_epi32(_mm256_setzero_si256(), 0xFF, countV, 1);
+	betterCount = SumLanes_AVX2(_mm256_add_epi32(low, high));
+	return i;
+}
+
+// ================= Dispatch =================
+
+// The best of best and the candidates
+inline float MaxCandidate(const float* candidates, size_t count, float best)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512: done = MaxCandidate_AVX512(candidates, count, best); break;
+		case SIMDLevel::AVX2: done = MaxCandidate_AVX2(candidates, count, best); break;
+		default: break;
+	}
+	for (size_t i = done; i < count; ++i)
+		best = std::max(best, candidates[i]);
+	return best;
+}
+
+// The index of the first candidate better than threshold, or count if none are
+inline size_t FindBetterCandidate(const float* candidates, size_t count, float threshold)
+{
+	size_t searched = 0;
+	size_t found = count;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512: found = FindBetterCandidate_AVX512(candidates, count, threshold, searched); break;
+		case SIMDLevel::AVX2: found = FindBetterCandidate_AVX2(candidates, count, threshold, searched); break;
+		default: break;
+	}
+	if (found != count)
+		return found;
+	for (size_t i = searched; i < count; ++i)
+	{
+		if (candidates[i] > threshold)
+			return i;
+	}
+	return count;
+}
+
+// How many candidates are better than threshold
+inline size_t CountBetterCandidates(const float* candidates, size_t count, float threshold)
+{
+	size_t betterCount = 0;
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512: done = CountBetterCandidates_AVX512(candidates, count, threshold, betterCount); break;
+		case SIMDLevel::AVX2: done = CountBetterCandidates_AVX2(candidates, count, threshold, betterCount); break;
+		default: break;
+	}
+	for (size_t i = done; i < count; ++i)
+		betterCount += (candidates[i] > threshold) ? 1 : 0;
+	return betterCount;
+}
+
+// ================= Scan =================
+
+// Takes the candidates any number at a time, in order, and keeps track of where it is in the three searches.
+// Candidates are in [0,1], and higher is better.
+class CandidateScan
+{
+public:
+	explicit CandidateScan(size_t cutoff)
+		: m_cutoff(cutoff)
+	{
+	}
+
+	void Scan(const float* candidates, size_t count)
+	{
+		size_t i = 0;
+
+		// The best before the cutoff
+		if (m_index < m_cutoff)
+		{
+			i = std::min(count, m_cutoff - m_index);
+			m_bestBeforeCutoff = MaxCandidate(candidates, i, m_bestBeforeCutoff);
+		}
+
+		// The first after the cutoff that beats it
+		if (!m_chosen && i < count)
+		{
+			size_t found = FindBetterCandidate(&candidates[i], count - i, m_bestBeforeCutoff);
+			if (found < count - i)
+			{
+				m_chosen = true;
+				m_chosenIndex = m_index + i + found;
+				m_chosenValue = candidates[i + found];
+				i += found + 1;
+			}
+			else
+			{
+				i = count;
+			}
+		}
+
+		// How many after that beat the one taken
+		if (m_chosen && i < count)
+			m_betterCount += CountBetterCandidates(&candidates[i], count - i, m_chosenValue);
+
+		m_index += count;
+	}
+
+	// If nothing after the cutoff beat the ones before it, the last candidate is the one taken, but it's counted as being as
+	// good as the best before the cutoff, which nothing is better than.
+	size_t ChosenIndex() const { return m_chosen ? m_chosenIndex : m_index - 1; }
+	size_t BetterCount() const { return m_betterCount; }
+
+private:
+	size_t m_cutoff;
+	size_t m_index = 0;
+	float m_bestBeforeCutoff = 0.0f;
+
+	bool m_chosen = false;
+	size_t m_chosenIndex = 0;
+	float m_chosenValue = 0.0f;
+	size_t m_betterCount = 0;
+};
+
+// ================= Cutoff Sweep =================
+
+// The outcome of every cutoff from 1 to count, from one set of candidates, without a scan per cutoff.
+//
+// A record is a candidate better than all of the ones before it. With cutoff k, the one taken is the first record at or
+// after k, because it beats the best before k, and everything between k and it doesn't. So going through the cutoffs from
+// count down to 1 and walking back through the records gives the one taken for each.
+//
+// Records get better as they go, and the only candidates that can beat a record come after it. Each candidate beats a run
+// of the records before it, from the first, which a binary search over the record values finds. Counting how many candidates
+// end their run at each record, and summing those from the last record back, gives how many beat each record.
+// That's O(count log records), and there are about log(count) records in random candidates.
+//
+// If no record comes at or after the cutoff, the last candidate is taken. Unlike CandidateScan, it's ranked as itself here,
+// so that the rank curve is the real rank all the way out to cutoff = count.
+class CandidateCutoffSweep
+{
+public:
+	// Adds the outcome of every cutoff to successes (1 if nothing beat the one taken) and betterCounts (how many did).
+	// Both are indexed by cutoff, and need count + 1 entries. Index 0 isn't touched.
+	void Add(const float* candidates, size_t count, uint64_t* successes, uint64_t* betterCounts)
+	{
+		// The records, and for each candidate, how many records it beats
+		m_records.clear();
+		m_recordValues.clear();
+		m_runEnds.assign(count + 1, 0);
+		float best = 0.0f;
+		for (size_t i = 0; i < count; ++i)
+		{
+			float value = candidates[i];
+			if (value > best)
+			{
+				m_runEnds[m_records.size()]++;
+				m_records.push_back(i);
+				m_recordValues.push_back(value);
+				best = value;
+			}
+			else
+			{
+				m_runEnds[std::lower_bound(m_recordValues.begin(), m_recordValues.end(), value) - m_recordValues.begin()]++;
+			}
+		}
+
+		// A candidate that beats the first run records adds to m_runEnds[run], and beats record r if run > r
+		m_betterCounts.resize(m_records.size());
+		uint64_t better = 0;
+		for (size_t r = m_records.size(); r-- > 0;)
+		{
+			better += m_runEnds[r + 1];
+			m_betterCounts[r] = better;
+		}
+
+		uint64_t lastBetterCount = (count > 0) ? CountBetterCandidates(candidates, count, candidates[count - 1]) : 0;
+
+		size_t record = m_records.size();
+		for (size_t cutoff = count; cutoff >= 1; --cutoff)
+		{
+			while (record > 0 && m_records[record - 1] >= cutoff)
+				record--;
+
+			uint64_t betterCount = (record < m_records.size()) ? m_betterCounts[record] : lastBetterCount;
+			successes[cutoff] += (record < m_records.size() && betterCount == 0) ? 1 : 0;
+			betterCounts[cutoff] += betterCount;
+		}
+	}
+
+private:
+	// Kept, so they don't allocate once they have grown large enough
+	std::vector<size_t> m_records;
+	std::vector<float> m_recordValues;
+	std::vector<uint64_t> m_runEnds;
+	std::vector<uint64_t> m_betterCounts;
+};
@@ -0,0 +1,809 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "SIMD.h"
+#include "RNGEngines.h"
+#include "CDFTable.h"
+
+// Noise shaping: uniform white noise is filtered to change its spectrum. A side effect is the noise becomes non uniform,
+// so it's then made uniform again by putting it through a piecewise cubic polynomial approximation of its CDF.
+// Switched to Horner's method polynomials, and a polynomial array to avoid branching, per Marc Reynolds. Thanks!
+//
+// FilteredNoiseStreamT takes the filter as a struct with:
+//   c_xTapCount, XTaps() - the taps on the white noise, newest first.
+//   c_yTapCount, YTaps() - the taps on the earlier filter outputs, newest first, for an IIR filter. 0 and nullptr for FIR.
+//   CDF()                - the NoiseCDF for the filter's output. FittedNoiseCDF<FILTER>() fits one automatically.
+// If CDF_TABLE_SIZE isn't 0, the stream uses a NoiseCDFTable of that size made from the NoiseCDF, instead of the polynomials.
+
+static const int c_maxNoiseCDFPieces = 8;  // so the SIMD paths can pick a piece with one 8 lane permute
+
+// x = y * scale + offset puts the filter output y in [0,1], and the CDF of x is pieceCount cubic polynomials of x,
+// each over an equal width piece of [0,1]. Highest power first.
+struct NoiseCDF
+{
+	float scale;
+	float offset;
+	int pieceCount;
+	float polynomials[c_maxNoiseCDFPieces * 4];
+};
+
+template <typename T>
+T EvaluateNoiseCDFPolynomial(const NoiseCDF& cdf, T x)
+{
+	const float* polynomial = &cdf.polynomials[std::min(int(x * float(cdf.pieceCount)), cdf.pieceCount - 1) * 4];
+	return MulThenAdd(x, MulThenAdd(x, MulThenAdd(x, T(polynomial[0]), T(polynomial[1])), T(polynomial[2])), T(polynomial[3]));
+}
+
+// The fits go through 0 and 1 at the ends, but the coefficients are rounded to floats, and the ends of the curve with them.
+// So the CDF is clamped into [0,1), the same as the white noise. The order of the compares is what max_ps and min_ps do.
+template <typename T>
+T ClampNoiseCDF(T value)
+{
+	const T belowOne = T(1) - std::numeric_limits<T>::epsilon() / T(2);
+	value = value > T(0) ? value : T(0);
+	return value < belowOne ? value : belowOne;
+}
+
+template <typename T>
+T EvaluateNoiseCDF(const NoiseCDF& cdf, T y)
+{
+	return ClampNoiseCDF(EvaluateNoiseCDFPolynomial(cdf, MulThenAdd(y, T(cdf.scale), T(cdf.offset))));
+}
+
+// The polynomials of a NoiseCDF, sampled into a CDFTable. Made at run time, from the NoiseCDF the filter gives.
+template <size_t SIZE>
+struct NoiseCDFTable
+{
+	explicit NoiseCDFTable(const NoiseCDF& cdf)
+		: scale(cdf.scale)
+		, offset(cdf.offset)
+		, table([&cdf](double x) { return EvaluateNoiseCDFPolynomial(cdf, x); })
+	{
+	}
+
+	float scale;
+	float offset;
+	CDFTable<SIZE> table;
+};
+
+template <size_t SIZE, typename T>
+T EvaluateNoiseCDF(const NoiseCDFTable<SIZE>& cdf, T y)
+{
+	return ClampNoiseCDF(EvaluateCDFTable(cdf.table, MulThenAdd(y, T(cdf.scale), T(cdf.offset))));
+}
+
+// ================= Fitting =================
+
+static const size_t c_noiseCDFFitSampleCount = 1 << 22;
+static const int c_noiseCDFFitBinCount = 4096;
+static const int c_noiseImpulseResponseLength = 4096;
+
+// Least squares fit of a cubic to the points, through the first and last of them exactly.
+// With u = x - center, and h half the width, the cubic is the line through the end points plus (u^2 - h^2)(a + b u),
+// which is 0 at both ends. a and b are fit to what the line leaves, in powers of u so the fit is well conditioned.
+// Returns the coefficients in powers of x, highest first.
+inline void FitCubic(const double* xs, const double* ys, size_t count, float* polynomial)
+{
+	double center = (xs[0] + xs[count - 1]) / 2.0;
+	double h = (xs[count - 1] - xs[0]) / 2.0;
+	double middle = (ys[0] + ys[count - 1]) / 2.0;
+	double slope = (ys[count - 1] - ys[0]) / (2.0 * h);
+
+	// Normal equations, solved with Cramer's rule
+	double m[2][3] = {};
+	for (size_t i = 0; i < count; ++i)
+	{
+		double u = xs[i] - center;
+		double basis[2] = { u * u - h * h, u * (u * u - h * h) };
+		double residual = ys[i] - (middle + slope * u);
+		for (int row = 0; row < 2; ++row)
+		{
+			for (int column = 0; column < 2; ++column)
+				m[row][column] += basis[row] * basis[column];
+			m[row][2] += basis[row] * residual;
+		}
+	}
+	double determinant = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+	double a = (m[0][2] * m[1][1] - m[0][1] * m[1][2]) / determinant;
+	double b = (m[0][0] * m[1][2] - m[1][0] * m[0][2]) / determinant;
+
+	// c[k] is the coefficient of u^k. Expand those into powers of x.
+	double c[4] = { middle - a * h * h, slope - b * h * h, a, b };
+	static const double c_binomial[4][4] = { { 1, 0, 0, 0 }, { 1, 1, 0, 0 }, { 1, 2, 1, 0 }, { 1, 3, 3, 1 } };
+	for (int power = 0; power < 4; ++power)
+	{
+		double coefficient = 0.0;
+		for (int k = power; k < 4; ++k)
+			coefficient += c[k] * c_binomial[k][power] * std::pow(-center, double(k - power));
+		polynomial[3 - power] = float(coefficient);
+	}
+}
+
+// Fits a NoiseCDF to a filter, by making noise with it, and fitting a cubic to each piece of the running total of its histogram.
+// Neighbouring pieces are fit through the same point where they meet, so they join up, and the ends go through 0 and 1.
+// It takes millions of filtered samples, which is far too much work to do at compile time, so it's done once at run time.
+// The output range comes from the impulse response: with white noise in [0,1], the output can't go below the sum of
+// the negative responses, or above the sum of the positive ones.
+inline NoiseCDF FitNoiseCDF(const float* xTaps, int xTapCount, const float* yTaps, int yTapCount, int pieceCount)
+{
+	std::vector<double> outputs(c_noiseImpulseResponseLength, 0.0);
+	double low = 0.0;
+	double high = 0.0;
+	for (int i = 0; i < c_noiseImpulseResponseLength; ++i)
+	{
+		double y = (i < xTapCount) ? xTaps[i] : 0.0;
+		for (int tap = 0; tap < yTapCount && tap < i; ++tap)
+			y += outputs[i - 1 - tap] * yTaps[tap];
+		outputs[i] = y;
+		(y < 0.0 ? low : high) += y;
+	}
+
+	NoiseCDF cdf = {};
+	cdf.scale = float(1.0 / (high - low));
+	cdf.offset = float((0.0 - low) / (high - low));
+	cdf.pieceCount = pieceCount;
+
+	// Histogram of filtered white noise, from a fixed seed so the fit is always the same.
+	// The first few are skipped so the filter's history is all real noise.
+	static const size_t c_skipCount = 64;
+	PCG32Engine engine(0, 0);
+	std::vector<double> whiteNoise(xTapCount, 0.0);
+	std::fill(outputs.begin(), outputs.end(), 0.0);
+	std::vector<size_t> histogram(c_noiseCDFFitBinCount, 0);
+	for (size_t sampleIndex = 0; sampleIndex < c_noiseCDFFitSampleCount + c_skipCount; ++sampleIndex)
+	{
+		for (int tap = xTapCount - 1; tap > 0; --tap)
+			whiteNoise[tap] = whiteNoise[tap - 1];
+		whiteNoise[0] = U32ToFloat01(engine.NextU32());
+
+		double y = 0.0;
+		for (int tap = 0; tap < xTapCount; ++tap)
+			y += whiteNoise[tap] * xTaps[tap];
+		for (int tap = 0; tap < yTapCount; ++tap)
+			y += outputs[tap] * yTaps[tap];
+		for (int tap = yTapCount - 1; tap > 0; --tap)
+			outputs[tap] = outputs[tap - 1];
+		if (yTapCount > 0)
+			outputs[0] = y;
+
+		if (sampleIndex < c_skipCount)
+			continue;
+		double x = (y - low) / (high - low);
+		histogram[std::min(std::max(int(x * c_noiseCDFFitBinCount), 0), c_noiseCDFFitBinCount - 1)]++;
+	}
+
+	// The CDF at each bin edge
+	std::vector<double> xs(c_noiseCDFFitBinCount + 1);
+	std::vector<double> ys(c_noiseCDFFitBinCount + 1);
+	size_t total = 0;
+	for (int bin = 0; bin <= c_noiseCDFFitBinCount; ++bin)
+	{
+		xs[bin] = double(bin) / double(c_noiseCDFFitBinCount);
+		ys[bin] = double(total) / double(c_noiseCDFFitSampleCount);
+		if (bin < c_noiseCDFFitBinCount)
+			total += histogram[bin];
+	}
+
+	int binsPerPiece = c_noiseCDFFitBinCount / pieceCount;
+	for (int piece = 0; piece < pieceCount; ++piece)
+		FitCubic(&xs[piece * binsPerPiece], &ys[piece * binsPerPiece], binsPerPiece + 1, &cdf.polynomials[piece * 4]);
+	return cdf;
+}
+
+// Fitted once, the first time it's asked for
+template <typename FILTER>
+const NoiseCDF& FittedNoiseCDF()
+{
+	static const NoiseCDF cdf = FitNoiseCDF(FILTER::XTaps(), FILTER::c_xTapCount, FILTER::YTaps(), FILTER::c_yTapCount, c_maxNoiseCDFPieces);
+	return cdf;
+}
+
+// ================= Scalar blocks =================
+// whiteNoise has count + TAP_COUNT - 1 values, starting with the TAP_COUNT - 1 that came before the block, oldest first.
+// These do the same float operations in the same order as FilteredNoiseStreamT::Next(), and so do the SIMD versions,
+// with no fused multiply adds, so they all give the same bits.
+// NoiseFilterCDF is for FIR filters. An IIR filter needs the feedback added in between NoiseFIR and EvaluateNoiseCDF.
+// CDF is a NoiseCDF or a NoiseCDFTable.
+
+template <int TAP_COUNT, typename T>
+T NoiseFIRScalar(const T* w, const float* taps)
+{
+	T y = w[0] * taps[0];
+	for (int tap = 1; tap < TAP_COUNT; ++tap)
+		y = MulThenAdd(w[-tap], T(taps[tap]), y);
+	return y;
+}
+
+template <int TAP_COUNT, typename T>
+void NoiseFIRScalar(const T* whiteNoise, T* out, size_t count, const float* taps)
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = NoiseFIRScalar<TAP_COUNT>(&whiteNoise[i + TAP_COUNT - 1], taps);
+}
+
+template <typename T, typename CDF>
+void EvaluateNoiseCDFScalar(const T* in, T* out, size_t count, const CDF& cdf)
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = EvaluateNoiseCDF(cdf, in[i]);
+}
+
+template <int TAP_COUNT, typename T, typename CDF>
+void NoiseFilterCDFScalar(const T* whiteNoise, T* out, size_t count, const float* taps, const CDF& cdf)
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = EvaluateNoiseCDF(cdf, NoiseFIRScalar<TAP_COUNT>(&whiteNoise[i + TAP_COUNT - 1], taps));
+}
+
+// The SIMD versions pick each lane's polynomial with a permute, from tables holding one coefficient of every piece.
+
+// ================= AVX2: 8 samples at a time =================
+
+SIMD_TARGET_AVX2 inline __m256 ClampNoiseCDF_AVX2(__m256 value)
+{
+	return _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f - std::numeric_limits<float>::epsilon() / 2.0f));
+}
+
+struct NoiseCDF_AVX2
+{
+	__m256 coefficients[4];
+	__m256 scale;
+	__m256 offset;
+	__m256 pieceCount;
+	__m256i lastPiece;
+};
+
+SIMD_TARGET_AVX2 inline NoiseCDF_AVX2 MakeNoiseCDF_AVX2(const NoiseCDF& cdf)
+{
+	// The polynomials array always has room for c_maxNoiseCDFPieces, and the unused pieces are never picked
+	NoiseCDF_AVX2 ret;
+	const __m256i pieceStarts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+	for (int i = 0; i < 4; ++i)
+		ret.coefficients[i] = _mm256_i32gather_ps(&cdf.polynomials[i], pieceStarts, 4);
+	ret.scale = _mm256_set1_ps(cdf.scale);
+	ret.offset = _mm256_set1_ps(cdf.offset);
+	ret.pieceCount = _mm256_set1_ps(float(cdf.pieceCount));
+	ret.lastPiece = _mm256_set1_epi32(cdf.pieceCount - 1);
+	return ret;
+}
+
+SIMD_TARGET_AVX2 inline __m256 EvaluateNoiseCDF_AVX2(__m256 y, const NoiseCDF_AVX2& cdf)
+{
+	__m256 x = _mm256_add_ps(_mm256_mul_ps(y, cdf.scale), cdf.offset);
+	__m256i piece = _mm256_min_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(x, cdf.pieceCount)), cdf.lastPiece);
+	__m256 value = _mm256_mul_ps(x, _mm256_permutevar8x32_ps(cdf.coefficients[0], piece));
+	value = _mm256_mul_ps(x, _mm256_add_ps(_mm256_permutevar8x32_ps(cdf.coefficients[1], piece), value));
+	value = _mm256_mul_ps(x, _mm256_add_ps(_mm256_permutevar8x32_ps(cdf.coefficients[2], piece), value));
+	return ClampNoiseCDF_AVX2(_mm256_add_ps(_mm256_permutevar8x32_ps(cdf.coefficients[3], piece), value));
+}
+
+template <size_t SIZE>
+struct NoiseCDFTable_AVX2
+{
+	const CDFTable<SIZE>* table;
+	__m256 scale;
+	__m256 offset;
+};
+
+template <size_t SIZE>
+SIMD_TARGET_AVX2 NoiseCDFTable_AVX2<SIZE> MakeNoiseCDF_AVX2(const NoiseCDFTable<SIZE>& cdf)
+{
+	NoiseCDFTable_AVX2<SIZE> ret;
+	ret.table = &cdf.table;
+	ret.scale = _mm256_set1_ps(cdf.scale);
+	ret.offset = _mm256_set1_ps(cdf.offset);
+	return ret;
+}
+
+template <size_t SIZE>
+SIMD_TARGET_AVX2 __m256 EvaluateNoiseCDF_AVX2(__m256 y, const NoiseCDFTable_AVX2<SIZE>& cdf)
+{
+	return ClampNoiseCDF_AVX2(EvaluateCDFTable_AVX2(*cdf.table, _mm256_add_ps(_mm256_mul_ps(y, cdf.scale), cdf.offset)));
+}
+
+// The taps are broadcast up front, since the stores could be to the same memory as far as the compiler knows
+template <int TAP_COUNT>
+SIMD_TARGET_AVX2 __m256 NoiseFIR_AVX2(const float* w, const __m256* taps)
+{
+	__m256 y = _mm256_mul_ps(_mm256_loadu_ps(w), taps[0]);
+	for (int tap = 1; tap < TAP_COUNT; ++tap)
+		y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_loadu_ps(w - tap), taps[tap]));
+	return y;
+}
+
+template <int TAP_COUNT>
+SIMD_TARGET_AVX2 void NoiseFIR_AVX2(const float* whiteNoise, float* out, size_t blockCount, const float* taps)
+{
+	__m256 tapsV[TAP_COUNT];
+	for (int tap = 0; tap < TAP_COUNT; ++tap)
+		tapsV[tap] = _mm256_set1_ps(taps[tap]);
+	for (size_t block = 0; block < blockCount; ++block)
+		_mm256_storeu_ps(&out[block * 8], NoiseFIR_AVX2<TAP_COUNT>(&whiteNoise[block * 8 + TAP_COUNT - 1], tapsV));
+}
+
+template <typename CDF>
+SIMD_TARGET_AVX2 void EvaluateNoiseCDF_AVX2(const float* in, float* out, size_t blockCount, const CDF& cdf)
+{
+	auto cdfV = MakeNoiseCDF_AVX2(cdf);
+	for (size_t block = 0; block < blockCount; ++block)
+		_mm256_storeu_ps(&out[block * 8], EvaluateNoiseCDF_AVX2(_mm256_loadu_ps(&in[block * 8]), cdfV));
+}
+
+template <int TAP_COUNT, typename CDF>
+SIMD_TARGET_AVX2 void NoiseFilterCDF_AVX2(const float* whiteNoise, float* out, size_t blockCount, const float* taps, const CDF& cdf)
+{
+	__m256 tapsV[TAP_COUNT];
+	for (int tap = 0; tap < TAP_COUNT; ++tap)
+		tapsV[tap] = _mm256_set1_ps(taps[tap]);
+	auto cdfV = MakeNoiseCDF_AVX2(cdf);
+	for (size_t block = 0; block < blockCount; ++block)
+	{
+		__m256 y = NoiseFIR_AVX2<TAP_COUNT>(&whiteNoise[block * 8 + TAP_COUNT - 1], tapsV);
+		_mm256_storeu_ps(&out[block * 8], EvaluateNoiseCDF_AVX2(y, cdfV));
+	}
+}
+
+// ================= AVX-512: 16 samples at a time =================
+
+SIMD_TARGET_AVX512 inline __m512 ClampNoiseCDF_AVX512(__m512 value)
+{
+	return _mm512_min_ps(_mm512_max_ps(value, _mm512_setzero_ps()), _mm512_set1_ps(1.0f - std::numeric_limits<float>::epsilon() / 2.0f));
+}
+
+struct NoiseCDF_AVX512
+{
+	__m512 coefficients[4];
+	__m512 scale;
+	__m512 offset;
+	__m512 pieceCount;
+	__m512i lastPiece;
+};
+
+SIMD_TARGET_AVX512 inline NoiseCDF_AVX512 MakeNoiseCDF_AVX512(const NoiseCDF& cdf)
+{
+	NoiseCDF_AVX512 ret;
+	const __m512i pieceStarts = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 0, 4, 8, 12, 16, 20, 24, 28);
+	// Masked, with a zero source, because gcc warns that the unmasked one reads an uninitialized register
+	for (int i = 0; i < 4; ++i)
+		ret.coefficients[i] = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, pieceStarts, &cdf.polynomials[i], 4);
+	ret.scale = _mm512_set1_ps(cdf.scale);
+	ret.offset = _mm512_set1_ps(cdf.offset);
+	ret.pieceCount = _mm512_set1_ps(float(cdf.pieceCount));
+	ret.lastPiece = _mm512_set1_epi32(cdf.pieceCount - 1);
+	return ret;
+}
+
+SIMD_TARGET_AVX512 inline __m512 EvaluateNoiseCDF_AVX512(__m512 y, const NoiseCDF_AVX512& cdf)
+{
+	__m512 x = _mm512_add_ps(_mm512_mul_ps(y, cdf.scale), cdf.offset);
+	__m512i piece = _mm512_min_epi32(_mm512_cvttps_epi32(_mm512_mul_ps(x, cdf.pieceCount)), cdf.lastPiece);
+	__m512 value = _mm512_mul_ps(x, _mm512_permutexvar_ps(piece, cdf.coefficients[0]));
+	value = _mm512_mul_ps(x, _mm512_add_ps(_mm512_permutexvar_ps(piece, cdf.coefficients[1]), value));
+	value = _mm512_mul_ps(x, _mm512_add_ps(_mm512_permutexvar_ps(piece, cdf.coefficients[2]), value));
+	return ClampNoiseCDF_AVX512(_mm512_add_ps(_mm512_permutexvar_ps(piece, cdf.coefficients[3]), value));
+}
+
+template <size_t SIZE>
+struct NoiseCDFTable_AVX512
+{
+	const CDFTable<SIZE>* table;
+	__m512 scale;
+	__m512 offset;
+};
+
+template <size_t SIZE>
+SIMD_TARGET_AVX512 NoiseCDFTable_AVX512<SIZE> MakeNoiseCDF_AVX512(const NoiseCDFTable<SIZE>& cdf)
+{
+	NoiseCDFTable_AVX512<SIZE> ret;
+	ret.table = &cdf.table;
+	ret.scale = _mm512_set1_ps(cdf.scale);
+	ret.offset = _mm512_set1_ps(cdf.offset);
+	return ret;
+}
+
+template <size_t SIZE>
+SIMD_TARGET_AVX512 __m512 EvaluateNoiseCDF_AVX512(__m512 y, const NoiseCDFTable_AVX512<SIZE>& cdf)
+{
+	return ClampNoiseCDF_AVX512(EvaluateCDFTable_AVX512(*cdf.table, _mm512_add_ps(_mm512_mul_ps(y, cdf.scale), cdf.offset)));
+}
+
+// The taps are broadcast up front, since the stores could be to the same memory as far as the compiler knows
+template <int TAP_COUNT>
+SIMD_TARGET_AVX512 __m512 NoiseFIR_AVX512(const float* w, const __m512* taps)
+{
+	__m512 y = _mm512_mul_ps(_mm512_loadu_ps(w), taps[0]);
+	for (int tap = 1; tap < TAP_COUNT; ++tap)
+		y = _mm512_add_ps(y, _mm512_mul_ps(_mm512_loadu_ps(w - tap), taps[tap]));
+	return y;
+}
+
+template <int TAP_COUNT>
+SIMD_TARGET_AVX512 void NoiseFIR_AVX512(const float* whiteNoise, float* out, size_t blockCount, const float* taps)
+{
+	__m512 tapsV[TAP_COUNT];
+	for (int tap = 0; tap < TAP_COUNT; ++tap)
+		tapsV[tap] = _mm512_set1_ps(taps[tap]);
+	for (size_t block = 0; block < blockCount; ++block)
+		_mm512_storeu_ps(&out[block * 16], NoiseFIR_AVX512<TAP_COUNT>(&whiteNoise[block * 16 + TAP_COUNT - 1], tapsV));
+}
+
+template <typename CDF>
+SIMD_TARGET_AVX512 void EvaluateNoiseCDF_AVX512(const float* in, float* out, size_t blockCount, const CDF& cdf)
+{
+	auto cdfV = MakeNoiseCDF_AVX512(cdf);
+	for (size_t block = 0; block < blockCount; ++block)
+		_mm512_storeu_ps(&out[block * 16], EvaluateNoiseCDF_AVX512(_mm512_loadu_ps(&in[block * 16]), cdfV));
+}
+
+template <int TAP_COUNT, typename CDF>
+SIMD_TARGET_AVX512 void NoiseFilterCDF_AVX512(const float* whiteNoise, float* out, size_t blockCount, const float* taps, const CDF& cdf)
+{
+	__m512 tapsV[TAP_COUNT];
+	for (int tap = 0; tap < TAP_COUNT; ++tap)
+		tapsV[tap] = _mm512_set1_ps(taps[tap]);
+	auto cdfV = MakeNoiseCDF_AVX512(cdf);
+	for (size_t block = 0; block < blockCount; ++block)
+	{
+		__m512 y = NoiseFIR_AVX512<TAP_COUNT>(&whiteNoise[block * 16 + TAP_COUNT - 1], tapsV);
+		_mm512_storeu_ps(&out[block * 16], EvaluateNoiseCDF_AVX512(y, cdfV));
+	}
+}
+
+// ================= Dispatch =================
+// Each does as many whole SIMD blocks as it can, and the rest in scalar.
+
+template <int TAP_COUNT>
+void NoiseFIR(const float* whiteNoise, float* out, size_t count, const float* taps)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512:
+		{
+			size_t blockCount = count / 16;
+			if (blockCount > 0)
+				NoiseFIR_AVX512<TAP_COUNT>(whiteNoise, out, blockCount, taps);
+			done = blockCount * 16;
+			break;
+		}
+		case SIMDLevel::AVX2:
+		{
+			size_t blockCount = count / 8;
+			if (blockCount > 0)
+				NoiseFIR_AVX2<TAP_COUNT>(whiteNoise, out, blockCount, taps);
+			done = blockCount * 8;
+			break;
+		}
+		default: break;
+	}
+	NoiseFIRScalar<TAP_COUNT>(&whiteNoise[done], &out[done], count - done, taps);
+}
+
+// in and out can be the same
+template <typename CDF>
+void EvaluateNoiseCDF(const float* in, float* out, size_t count, const CDF& cdf)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512:
+		{
+			size_t blockCount = count / 16;
+			if (blockCount > 0)
+				EvaluateNoiseCDF_AVX512(in, out, blockCount, cdf);
+			done = blockCount * 16;
+			break;
+		}
+		case SIMDLevel::AVX2:
+		{
+			size_t blockCount = count / 8;
+			if (blockCount > 0)
+				EvaluateNoiseCDF_AVX2(in, out, blockCount, cdf);
+			done = blockCount * 8;
+			break;
+		}
+		default: break;
+	}
+	EvaluateNoiseCDFScalar(&in[done], &out[done], count - done, cdf);
+}
+
+template <int TAP_COUNT, typename CDF>
+void NoiseFilterCDF(const float* whiteNoise, float* out, size_t count, const float* taps, const CDF& cdf)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512:
+		{
+			size_t blockCount = count / 16;
+			if (blockCount > 0)
+				NoiseFilterCDF_AVX512<TAP_COUNT>(whiteNoise, out, blockCount, taps, cdf);
+			done = blockCount * 16;
+			break;
+		}
+		case SIMDLevel::AVX2:
+		{
+			size_t blockCount = count / 8;
+			if (blockCount > 0)
+				NoiseFilterCDF_AVX2<TAP_COUNT>(whiteNoise, out, blockCount, taps, cdf);
+			done = blockCount * 8;
+			break;
+		}
+		default: break;
+	}
+	NoiseFilterCDFScalar<TAP_COUNT>(&whiteNoise[done], &out[done], count - done, taps, cdf);
+}
+
+// There's no SIMD for doubles
+template <int TAP_COUNT>
+void NoiseFIR(const double* whiteNoise, double* out, size_t count, const float* taps)
+{
+	NoiseFIRScalar<TAP_COUNT>(whiteNoise, out, count, taps);
+}
+
+template <typename CDF>
+void EvaluateNoiseCDF(const double* in, double* out, size_t count, const CDF& cdf)
+{
+	EvaluateNoiseCDFScalar(in, out, count, cdf);
+}
+
+template <int TAP_COUNT, typename CDF>
+void NoiseFilterCDF(const double* whiteNoise, double* out, size_t count, const float* taps, const CDF& cdf)
+{
+	NoiseFilterCDFScalar<TAP_COUNT>(whiteNoise, out, count, taps, cdf);
+}
+
+// ================= Stream =================
+
+// The CDF a stream uses
+template <typename FILTER, size_t CDF_TABLE_SIZE>
+struct FilterCDF
+{
+	typedef NoiseCDFTable<CDF_TABLE_SIZE> Type;
+
+	// Made once, the first time it's asked for
+	static const Type& Get()
+	{
+		static const Type table(FILTER::CDF());
+		return table;
+	}
+};
+
+template <typename FILTER>
+struct FilterCDF<FILTER, 0>
+{
+	typedef NoiseCDF Type;
+
+	static const Type& Get() { return FILTER::CDF(); }
+};
+
+// The white noise comes from ENGINE, see RNGEngines.h.
+// T is float, or double for more bits of precision. The taps and CDF coefficients are floats either way.
+template <typename ENGINE, typename FILTER, typename T = float, size_t CDF_TABLE_SIZE = 0>
+class FilteredNoiseStreamT
+{
+public:
+	FilteredNoiseStreamT(const ENGINE& engine)
+		: m_engine(engine)
+		, m_cdf(&FilterCDF<FILTER, CDF_TABLE_SIZE>::Get())
+	{
+		for (int i = 0; i < c_historySize; ++i)
+			m_lastValues[i] = RandomFloat01();
+	}
+
+	T Next()
+	{
+		T y = NextFIR();
+		AddFeedback(y);
+		return EvaluateNoiseCDF(*m_cdf, y);
+	}
+
+	// Same as calling Next() count times.
+	// The white noise left in the block is used up first, and after that, white noise is made straight from the engine
+	// a big block at a time. The engines give the same numbers no matter how the fills are split up.
+	// The FIR part of the filter and the CDF are done in SIMD. The IIR part, if there is one, has to be done in order.
+	void NextN(T* out, size_t count)
+	{
+		static const size_t c_blockSize = 256;
+		T whiteNoise[c_blockSize + c_historySize];
+
+		size_t done = 0;
+		while (done < count)
+		{
+			for (int i = 0; i < c_historySize; ++i)
+				whiteNoise[i] = m_lastValues[c_historySize - 1 - i];
+
+			size_t blockCount;
+			if (m_whiteNoiseIndex < c_whiteNoiseBlockSize)
+			{
+				blockCount = std::min(count - done, c_whiteNoiseBlockSize - m_whiteNoiseIndex);
+				std::copy(&m_whiteNoise[m_whiteNoiseIndex], &m_whiteNoise[m_whiteNoiseIndex + blockCount], &whiteNoise[c_historySize]);
+				m_whiteNoiseIndex += blockCount;
+			}
+			else
+			{
+				blockCount = std::min(count - done, c_blockSize);
+				m_engine.Fill(&whiteNoise[c_historySize], blockCount);
+			}
+
+			T* block = &out[done];
+			if (FILTER::c_yTapCount == 0)
+			{
+				NoiseFilterCDF<FILTER::c_xTapCount>(whiteNoise, block, blockCount, FILTER::XTaps(), *m_cdf);
+			}
+			else
+			{
+				NoiseFIR<FILTER::c_xTapCount>(whiteNoise, block, blockCount, FILTER::XTaps());
+				for (size_t i = 0; i < blockCount; ++i)
+					AddFeedback(block[i]);
+				EvaluateNoiseCDF(block, block, blockCount, *m_cdf);
+			}
+
+			for (int i = 0; i < c_historySize; ++i)
+				m_lastValues[i] = whiteNoise[c_historySize + blockCount - 1 - i];
+			done += blockCount;
+		}
+	}
+
+	// Same as calling Next() count times, but jumps the engine instead of making the white noise in between.
+	// A FIR filter only needs the last c_xTapCount - 1 white noise values, so that's exact.
+	// An IIR filter's output depends on everything before it, so it's rebuilt from a warm up before the target, the same
+	// way BlueNoiseStreamAppletonT::Discard does. Each step of the feedback is rounded, but is monotone in each earlier output:
+	// increasing for a positive tap, and decreasing for a negative one. So the real outputs stay between a low and a high
+	// bound on them, started from the most any output could be either way, and once the bounds meet, the real outputs are
+	// where they are. If they haven't met by the target, the warm up is doubled.
+	void Discard(uint64_t count)
+	{
+		if (FILTER::c_yTapCount == 0 && DiscardFrom(count, 0))
+			return;
+		for (uint64_t warmup = c_iirDiscardWarmup; FILTER::c_yTapCount > 0 && warmup + c_historySize <= count; warmup *= 2)
+		{
+			if (DiscardFrom(count, warmup))
+				return;
+		}
+		for (uint64_t i = 0; i < count; ++i)
+			Next();
+	}
+
+private:
+	static const int c_historySize = FILTER::c_xTapCount - 1;
+	static const int c_outputCount = FILTER::c_yTapCount > 0 ? FILTER::c_yTapCount : 1;
+	static const uint64_t c_iirDiscardWarmup = 256;
+
+	// The FIR part of the filter, on the next white noise value, which then goes in the history
+	T NextFIR()
+	{
+		T value = RandomFloat01();
+
+		const float* xTaps = FILTER::XTaps();
+		T y = value * xTaps[0];
+		for (int tap = 1; tap < FILTER::c_xTapCount; ++tap)
+			y = MulThenAdd(m_lastValues[tap - 1], T(xTaps[tap]), y);
+
+		for (int i = c_historySize - 1; i > 0; --i)
+			m_lastValues[i] = m_lastValues[i - 1];
+		if (c_historySize > 0)
+			m_lastValues[0] = value;
+		return y;
+	}
+
+	// Jumps the white noise to warmup + c_historySize samples before count, and runs the feedback bounds from there.
+	// Returns false, and leaves the stream alone, if the bounds haven't met by count.
+	bool DiscardFrom(uint64_t count, uint64_t warmup)
+	{
+		T bound = FeedbackBound();
+		if (count < warmup + c_historySize || !(bound > T(0)))
+			return false;
+
+		// Skip all but the last few, using up the buffered ones first
+		FilteredNoiseStreamT stream = *this;
+		uint64_t skip = count - warmup - c_historySize;
+		size_t buffered = c_whiteNoiseBlockSize - stream.m_whiteNoiseIndex;
+		if (skip <= buffered)
+		{
+			stream.m_whiteNoiseIndex += (size_t)skip;
+		}
+		else
+		{
+			stream.m_whiteNoiseIndex = c_whiteNoiseBlockSize;
+			stream.m_engine.template Discard<T>(skip - buffered);
+		}
+		for (int i = c_historySize - 1; i >= 0; --i)
+			stream.m_lastValues[i] = stream.RandomFloat01();
+
+		T lowOutputs[c_outputCount];
+		T highOutputs[c_outputCount];
+		std::fill(lowOutputs, lowOutputs + c_outputCount, -bound);
+		std::fill(highOutputs, highOutputs + c_outputCount, bound);
+		for (uint64_t i = 0; i < warmup; ++i)
+			AddFeedbackBounds(stream.NextFIR(), lowOutputs, highOutputs);
+		if (!std::equal(lowOutputs, lowOutputs + FILTER::c_yTapCount, highOutputs))
+			return false;
+
+		std::copy(lowOutputs, lowOutputs + FILTER::c_yTapCount, stream.m_lastOutputs);
+		*this = stream;
+		return true;
+	}
+
+	// The most any output could be, either way. The FIR part is within the sum of the x taps, since white noise is in [0,1),
+	// and the feedback adds at most the sum of the y taps of that, over and over. That's doubled, for the rounding.
+	// 0 if the y taps add up to nearly 1 or more, which can't be bounded this way.
+	static T FeedbackBound()
+	{
+		double xSum = 0.0;
+		for (int tap = 0; tap < FILTER::c_xTapCount; ++tap)
+			xSum += std::abs(FILTER::XTaps()[tap]);
+		double ySum = 0.0;
+		for (int tap = 0; tap < FILTER::c_yTapCount; ++tap)
+			ySum += std::abs(FILTER::YTaps()[tap]);
+		return (ySum < 0.999) ? T(2.0 * xSum / (1.0 - ySum)) : T(0);
+	}
+
+	// AddFeedback, on a low and a high bound of each earlier output. The new low bound takes the low bound of an output with
+	// a positive tap, and the high bound of one with a negative tap, and the other way around for the new high bound.
+	static void AddFeedbackBounds(T y, T* lowOutputs, T* highOutputs)
+	{
+		if (FILTER::c_yTapCount == 0)
+			return;
+
+		const float* yTaps = FILTER::YTaps();
+		T low = y;
+		T high = y;
+		for (int tap = 0; tap < FILTER::c_yTapCount; ++tap)
+		{
+			bool positive = yTaps[tap] >= 0.0f;
+			low = MulThenAdd(positive ? lowOutputs[tap] : highOutputs[tap], T(yTaps[tap]), low);
+			high = MulThenAdd(positive ? highOutputs[tap] : lowOutputs[tap], T(yTaps[tap]), high);
+		}
+
+		for (int i = FILTER::c_yTapCount - 1; i > 0; --i)
+		{
+			lowOutputs[i] = lowOutputs[i - 1];
+			highOutputs[i] = highOutputs[i - 1];
+		}
+		lowOutputs[0] = low;
+		highOutputs[0] = high;
+	}
+
+	// The IIR part of the filter. Adds the earlier outputs to y, and then y becomes the newest one.
+	void AddFeedback(T& y)
+	{
+		if (FILTER::c_yTapCount == 0)
+			return;
+
+		const float* yTaps = FILTER::YTaps();
+		for (int tap = 0; tap < FILTER::c_yTapCount; ++tap)
+			y = MulThenAdd(m_lastOutputs[tap], T(yTaps[tap]), y);
+
+		for (int i = FILTER::c_yTapCount - 1; i > 0; --i)
+			m_lastOutputs[i] = m_lastOutputs[i - 1];
+		m_lastOutputs[0] = y;
+	}
+
+	T RandomFloat01()
+	{
+		// return a uniform white noise random float between 0 and 1.
+		// Can use whatever RNG you want, such as std::mt19937.
+		// White noise is made a block at a time.
+		if (m_whiteNoiseIndex == c_whiteNoiseBlockSize)
+		{
+			m_engine.Fill(m_whiteNoise, c_whiteNoiseBlockSize);
+			m_whiteNoiseIndex = 0;
+		}
+		return m_whiteNoise[m_whiteNoiseIndex++];
+	}
+
+	static const size_t c_whiteNoiseBlockSize = 32;
+
+	ENGINE m_engine;
+	const typename FilterCDF<FILTER, CDF_TABLE_SIZE>::Type* m_cdf;
+	T m_lastValues[c_historySize > 0 ? c_historySize : 1] = {};
+	T m_lastOutputs[c_outputCount] = {};
+	T m_whiteNoise[c_whiteNoiseBlockSize];
+	size_t m_whiteNoiseIndex = c_whiteNoiseBlockSize;
+};
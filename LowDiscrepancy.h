@@ -0,0 +1,244 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SIMD.h"
+#include "RNGEngines.h"
+
+// 1D low discrepancy sequences, generated incrementally so each sample is a few integer operations.
+// Each one also has At(index) to calculate any sample directly, and Seek(index) to continue from there.
+// At() returns 0.64 fixed point, same as WeylSequence, and Fill(out, count) takes the same types the engines do.
+//
+// The base 2 sequences have 32 bits of precision, so repeat every 2^32 samples.
+// Each one is randomized per sequence, from a seed, so that different sequences are different:
+//   VanDerCorputSequence - random digital shift: xor with the seed
+//   SobolSequence        - Owen scrambling
+//   HaltonSequence       - Cranley-Patterson rotation: add the seed, mod 1
+
+inline uint32_t ReverseBits32(uint32_t x)
+{
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+	x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+	return (x >> 16) | (x << 16);
+}
+
+// The index of the bit that flips when going from index - 1 to index, treating the index as 32 bits.
+// Going from 2^32 - 1 back to 0 flips them all, which is bit 31 as far as the sequences are concerned.
+inline unsigned int IncrementBit(uint64_t index)
+{
+	uint32_t low = (uint32_t)index;
+	return low ? CountTrailingZeros(low) : 31;
+}
+
+// The Laine-Karras style hash from "Practical Hash-based Owen Scrambling", Brent Burley 2020.
+// x is bit reversed, so each bit is only changed by the bits below it, which are the ones above it in the sample.
+// That makes it a nested uniform scramble (Owen scrambling) of the sample.
+inline uint32_t LaineKarrasPermutation(uint32_t x, uint32_t seed)
+{
+	x ^= x * 0x3d20adeau;
+	x += seed;
+	x *= (seed >> 16) | 1;
+	x ^= x * 0x05526c56u;
+	x ^= x * 0x53a22864u;
+	return x;
+}
+
+// Base 2 radical inverse: the bits of the index, mirrored around the binary point.
+// Going to the next index flips the lowest bits up to and including the lowest 0 bit, so the sample flips the same bits, mirrored.
+class VanDerCorputSequence
+{
+public:
+	VanDerCorputSequence(uint64_t seed)
+		: m_seed((uint32_t)(seed >> 32))
+	{
+	}
+
+	template <typename T>
+	void Fill(T* out, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			StoreSample64(&out[i], (uint64_t)(m_value ^ m_seed) << 32);
+			m_index++;
+			m_value ^= ~0u << (31 - IncrementBit(m_index));
+		}
+	}
+
+	uint64_t At(uint64_t index) const
+	{
+		return (uint64_t)(ReverseBits32((uint32_t)index) ^ m_seed) << 32;
+	}
+
+	void Seek(uint64_t index)
+	{
+		m_index = index;
+		m_value = ReverseBits32((uint32_t)index);
+	}
+
+private:
+	uint32_t m_seed;
+	uint64_t m_index = 0;
+	uint32_t m_value = 0;
+};
+
+// Sobol's second dimension, from the primitive polynomial x + 1. The first dimension is van der Corput.
+// Samples are made in Gray code order, which only changes one bit of the index each step, so each step is one xor
+// of a direction number. Which is still a Sobol sequence, just with the samples of each power of 2 block reordered.
+// The state is kept bit reversed, ready for the Owen scrambling.
+class SobolSequence
+{
+public:
+	SobolSequence(uint64_t seed)
+		: m_seed((uint32_t)(seed >> 32))
+	{
+	}
+
+	template <typename T>
+	void Fill(T* out, size_t count)
+	{
+		const uint32_t* directions = ReversedDirections();
+		for (size_t i = 0; i < count; ++i)
+		{
+			StoreSample64(&out[i], Scramble(m_reversedValue));
+			m_index++;
+			m_reversedValue ^= directions[IncrementBit(m_index)];
+		}
+	}
+
+	uint64_t At(uint64_t index) const
+	{
+		return Scramble(ReversedValue(index));
+	}
+
+	void Seek(uint64_t index)
+	{
+		m_index = index;
+		m_reversedValue = ReversedValue(index);
+	}
+
+private:
+	static const uint32_t* ReversedDirections()
+	{
+		struct Directions
+		{
+			Directions()
+			{
+				uint32_t v = 1u << 31;
+				for (int i = 0; i < 32; ++i)
+				{
+					reversed[i] = ReverseBits32(v);
+					v ^= v >> 1;
+				}
+			}
+			uint32_t reversed[32];
+		};
+		static const Directions directions;
+		return directions.reversed;
+	}
+
+	static uint32_t ReversedValue(uint64_t index)
+	{
+		const uint32_t* directions = ReversedDirections();
+		uint32_t index32 = (uint32_t)index;
+		uint32_t gray = index32 ^ (index32 >> 1);
+		uint32_t value = 0;
+		for (int i = 0; gray != 0; ++i, gray >>= 1)
+		{
+			if (gray & 1)
+				value ^= directions[i];
+		}
+		return value;
+	}
+
+	uint64_t Scramble(uint32_t reversedValue) const
+	{
+		return (uint64_t)ReverseBits32(LaineKarrasPermutation(reversedValue, m_seed)) << 32;
+	}
+
+	uint32_t m_seed;
+	uint64_t m_index = 0;
+	uint32_t m_reversedValue = 0;
+};
+
+// Base BASE radical inverse, in 0.64 fixed point. BASE should be an odd prime. Base 2 is VanDerCorputSequence.
+// Digit k of the index is worth 2^64 / BASE^(k+1) in the sample, so incrementing the index adds or subtracts those as the digits
+// count up and carry. Digit values are rounded down, so a sample is off by at most a few parts in 2^64, but the same few
+// parts no matter how it was calculated.
+template <uint32_t BASE>
+class HaltonSequence
+{
+public:
+	HaltonSequence(uint64_t seed)
+		: m_seed(seed)
+	{
+	}
+
+	template <typename T>
+	void Fill(T* out, size_t count)
+	{
+		const uint64_t* digitValues = DigitValues();
+		for (size_t i = 0; i < count; ++i)
+		{
+			StoreSample64(&out[i], m_value + m_seed);
+			for (int digit = 0; digit < c_maxDigits; ++digit)
+			{
+				if (++m_digits[digit] < BASE)
+				{
+					m_value += digitValues[digit];
+					break;
+				}
+				m_digits[digit] = 0;
+				m_value -= (BASE - 1) * digitValues[digit];
+			}
+		}
+	}
+
+	uint64_t At(uint64_t index) const
+	{
+		const uint64_t* digitValues = DigitValues();
+		uint64_t value = 0;
+		for (int digit = 0; index != 0; ++digit, index /= BASE)
+			value += (index % BASE) * digitValues[digit];
+		return value + m_seed;
+	}
+
+	void Seek(uint64_t index)
+	{
+		const uint64_t* digitValues = DigitValues();
+		m_value = 0;
+		for (int digit = 0; digit < c_maxDigits; ++digit, index /= BASE)
+		{
+			m_digits[digit] = (uint32_t)(index % BASE);
+			m_value += m_digits[digit] * digitValues[digit];
+		}
+	}
+
+private:
+	static const int c_maxDigits = 64;
+
+	static const uint64_t* DigitValues()
+	{
+		struct Table
+		{
+			Table()
+			{
+				// 2^64 / BASE^(k+1), rounded down. BASE isn't a power of 2, so (2^64 - 1) / BASE^(k+1) is the same thing.
+				uint64_t power = BASE;
+				for (int digit = 0; digit < c_maxDigits; ++digit)
+				{
+					values[digit] = power ? ~0ull / power : 0;
+					power = (power && power <= ~0ull / BASE) ? power * BASE : 0;
+				}
+			}
+			uint64_t values[c_maxDigits];
+		};
+		static const Table table;
+		return table.values;
+	}
+
+	uint64_t m_seed;
+	uint64_t m_value = 0;
+	uint32_t m_digits[c_maxDigits] = {};
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <stddef.h>
+#include "pcg/pcg_basic.h"
+#include "SIMD.h"
+
+// Multi-lane PCG32.
+// Lane k starts k steps into the stream, and every lane steps N at a time, so N lanes running in lockstep
+// produce exactly the numbers that N calls to pcg32_random_r would, in the same order.
+// Stepping N at a time is still an LCG: state * A^N + inc * (A^(N-1) + ... + A + 1).
+
+static const uint64_t c_pcg32Multiplier = 6364136223846793005ULL;
+
+// [0,1) float from the top 24 bits. Exact, unlike ldexpf((float)x, -32), which can round up to 1.0.
+inline float U32ToFloat01(uint32_t x)
+{
+	return float(x >> 8) * (1.0f / 16777216.0f);
+}
+
+// Sets up laneCount lanes which together continue the stream of rng
+inline void PCG32xNSetup(const pcg32_random_t& rng, size_t laneCount, uint64_t* laneStates, uint64_t& mult, uint64_t& inc)
+{
+	mult = 1;
+	inc = 0;
+	uint64_t state = rng.state;
+	for (size_t i = 0; i < laneCount; ++i)
+	{
+		laneStates[i] = state;
+		state = state * c_pcg32Multiplier + rng.inc;
+		inc = inc * c_pcg32Multiplier + rng.inc;
+		mult *= c_pcg32Multiplier;
+	}
+}
+
+// ================= AVX2: 8 lanes =================
+
+SIMD_TARGET_AVX2 inline __m256i PCG32xN_Mul64_AVX2(__m256i a, __m256i b)
+{
+	// There's no 64 bit multiply in AVX2, so build the low 64 bits out of 32x32 multiplies.
+	__m256i aHi = _mm256_srli_epi64(a, 32);
+	__m256i bHi = _mm256_srli_epi64(b, 32);
+	__m256i lolo = _mm256_mul_epu32(a, b);
+	__m256i cross = _mm256_add_epi64(_mm256_mul_epu32(aHi, b), _mm256_mul_epu32(a, bHi));
+	return _mm256_add_epi64(lolo, _mm256_slli_epi64(cross, 32));
+}
+
+// PCG32 output of 4 states, in the low 32 bits of each 64 bit lane
+SIMD_TARGET_AVX2 inline __m256i PCG32xN_Output_AVX2(__m256i oldstate)
+{
+	__m256i xorshifted = _mm256_srli_epi64(_mm256_xor_si256(_mm256_srli_epi64(oldstate, 18), oldstate), 27);
+	__m256i rot = _mm256_srli_epi64(oldstate, 59);
+	__m256i rotLeft = _mm256_and_si256(_mm256_sub_epi32(_mm256_setzero_si256(), rot), _mm256_set1_epi32(31));
+	return _mm256_or_si256(_mm256_srlv_epi32(xorshifted, rot), _mm256_sllv_epi32(xorshifted, rotLeft));
+}
+
+SIMD_TARGET_AVX2 inline void PCG32xN_Store_AVX2(uint32_t* out, __m256i v)
+{
+	_mm256_storeu_si256((__m256i*)out, v);
+}
+
+SIMD_TARGET_AVX2 inline void PCG32xN_Store_AVX2(float* out, __m256i v)
+{
+	_mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(v, 8)), _mm256_set1_ps(1.0f / 16777216.0f)));
+}
+
+// Fills blockCount * 8 values and advances rng past them
+template <typename T>
+SIMD_TARGET_AVX2 void PCG32xN_Fill_AVX2(pcg32_random_t& rng, T* out, size_t blockCount)
+{
+	uint64_t laneStates[8];
+	uint64_t mult, inc;
+	PCG32xNSetup(rng, 8, laneStates, mult, inc);
+
+	__m256i state0 = _mm256_loadu_si256((const __m256i*)&laneStates[0]);
+	__m256i state1 = _mm256_loadu_si256((const __m256i*)&laneStates[4]);
+	const __m256i multV = _mm256_set1_epi64x((long long)mult);
+	const __m256i incV = _mm256_set1_epi64x((long long)inc);
+	const __m256i packIndex = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+	for (size_t block = 0; block < blockCount; ++block)
+	{
+		__m256i out0 = _mm256_permutevar8x32_epi32(PCG32xN_Output_AVX2(state0), packIndex);
+		__m256i out1 = _mm256_permutevar8x32_epi32(PCG32xN_Output_AVX2(state1), packIndex);
+		PCG32xN_Store_AVX2(&out[block * 8], _mm256_permute2x128_si256(out0, out1, 0x20));
+
+		state0 = _mm256_add_epi64(PCG32xN_Mul64_AVX2(state0, multV), incV);
+		state1 = _mm256_add_epi64(PCG32xN_Mul64_AVX2(state1, multV), incV);
+	}
+
+	_mm256_storeu_si256((__m256i*)&laneStates[0], state0);
+	rng.state = laneStates[0];
+}
+
+// pcg32_srandom_r(rngs[i], seed, firstStream + i) for 4 rngs: a step from 0, add the seed, and another step
+SIMD_TARGET_AVX2 inline void PCG32xN_SeedStreams_AVX2(pcg32_random_t* rngs, uint64_t seed, uint64_t firstStream)
+{
+	__m256i streams = _mm256_add_epi64(_mm256_set1_epi64x((long long)firstStream), _mm256_setr_epi64x(0, 1, 2, 3));
+	__m256i inc = _mm256_or_si256(_mm256_slli_epi64(streams, 1), _mm256_set1_epi64x(1));
+	__m256i state = _mm256_add_epi64(PCG32xN_Mul64_AVX2(_mm256_add_epi64(inc, _mm256_set1_epi64x((long long)seed)), _mm256_set1_epi64x((long long)c_pcg32Multiplier)), inc);
+	__m256i lo = _mm256_unpacklo_epi64(state, inc);
+	__m256i hi = _mm256_unpackhi_epi64(state, inc);
+	_mm256_storeu_si256((__m256i*)&rngs[0], _mm256_permute2x128_si256(lo, hi, 0x20));
+	_mm256_storeu_si256((__m256i*)&rngs[2], _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+// ================= AVX-512: 16 lanes =================
+
+SIMD_TARGET_AVX512 inline __m256i PCG32xN_Output_AVX512(__m512i oldstate)
+{
+	__m512i xorshifted = _mm512_srli_epi64(_mm512_xor_si512(_mm512_srli_epi64(oldstate, 18), oldstate), 27);
+	__m512i rot = _mm512_srli_epi64(oldstate, 59);
+	return _mm512_cvtepi64_epi32(_mm512_rorv_epi32(xorshifted, rot));
+}
+
+SIMD_TARGET_AVX512 inline void PCG32xN_Store_AVX512(uint32_t* out, __m512i v)
+{
+	_mm512_storeu_si512((void*)out, v);
+}
+
+SIMD_TARGET_AVX512 inline void PCG32xN_Store_AVX512(float* out, __m512i v)
+{
+	_mm512_storeu_ps(out, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(v, 8)), _mm512_set1_ps(1.0f / 16777216.0f)));
+}
+
+// Fills blockCount * 16 values and advances rng past them
+template <typename T>
+SIMD_TARGET_AVX512 void PCG32xN_Fill_AVX512(pcg32_random_t& rng, T* out, size_t blockCount)
+{
+	uint64_t laneStates[16];
+	uint64_t mult, inc;
+	PCG32xNSetup(rng, 16, laneStates, mult, inc);
+
+	__m512i state0 = _mm512_loadu_si512((const void*)&laneStates[0]);
+	__m512i state1 = _mm512_loadu_si512((const void*)&laneStates[8]);
+	const __m512i multV = _mm512_set1_epi64((long long)mult);
+	const __m512i incV = _mm512_set1_epi64((long long)inc);
+
+	for (size_t block = 0; block < blockCount; ++block)
+	{
+		__m512i outV = _mm512_inserti64x4(_mm512_castsi256_si512(PCG32xN_Output_AVX512(state0)), PCG32xN_Output_AVX512(state1), 1);
+		PCG32xN_Store_AVX512(&out[block * 16], outV);
+
+		state0 = _mm512_add_epi64(_mm512_mullo_epi64(state0, multV), incV);
+		state1 = _mm512_add_epi64(_mm512_mullo_epi64(state1, multV), incV);
+	}
+
+	_mm512_storeu_si512((void*)&laneStates[0], state0);
+	rng.state = laneStates[0];
+}
+
+// pcg32_srandom_r(rngs[i], seed, firstStream + i) for 8 rngs
+SIMD_TARGET_AVX512 inline void PCG32xN_SeedStreams_AVX512(pcg32_random_t* rngs, uint64_t seed, uint64_t firstStream)
+{
+	__m512i streams = _mm512_add_epi64(_mm512_set1_epi64((long long)firstStream), _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+	__m512i inc = _mm512_or_si512(_mm512_add_epi64(streams, streams), _mm512_set1_epi64(1));
+	__m512i state = _mm512_add_epi64(_mm512_mullo_epi64(_mm512_add_epi64(inc, _mm512_set1_epi64((long long)seed)), _mm512_set1_epi64((long long)c_pcg32Multiplier)), inc);
+	_mm512_storeu_si512((void*)&rngs[0], _mm512_permutex2var_epi64(state, _mm512_setr_epi64(0, 8, 1, 9, 2, 10, 3, 11), inc));
+	_mm512_storeu_si512((void*)&rngs[4], _mm512_permutex2var_epi64(state, _mm512_setr_epi64(4, 12, 5, 13, 6, 14, 7, 15), inc));
+}
+
+// ================= Dispatch =================
+
+inline void PCG32FillScalar(pcg32_random_t& rng, uint32_t* out, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = pcg32_random_r(&rng);
+}
+
+inline void PCG32FillScalar(pcg32_random_t& rng, float* out, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = U32ToFloat01(pcg32_random_r(&rng));
+}
+
+// Fills out with the next count numbers of rng, and advances rng past them.
+// T is uint32_t for raw output, or float for [0,1) floats.
+template <typename T>
+void PCG32Fill(pcg32_random_t& rng, T* out, size_t count)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512:
+		{
+			size_t blockCount = count / 16;
+			if (blockCount > 0)
+				PCG32xN_Fill_AVX512(rng, out, blockCount);
+			done = blockCount * 16;
+			break;
+		}
+		case SIMDLevel::AVX2:
+		{
+			size_t blockCount = count / 8;
+			if (blockCount > 0)
+				PCG32xN_Fill_AVX2(rng, out, blockCount);
+			done = blockCount * 8;
+			break;
+		}
+		default: break;
+	}
+	PCG32FillScalar(rng, out + done, count - done);
+}
+
+// pcg32_srandom_r(rngs[i], seed, firstStream + i), for count rngs
+inline void PCG32SeedStreams(pcg32_random_t* rngs, uint64_t seed, uint64_t firstStream, size_t count)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512:
+			for (; done + 8 <= count; done += 8)
+				PCG32xN_SeedStreams_AVX512(&rngs[done], seed, firstStream + done);
+			break;
+		case SIMDLevel::AVX2:
+			for (; done + 4 <= count; done += 4)
+				PCG32xN_SeedStreams_AVX2(&rngs[done], seed, firstStream + done);
+			break;
+		default: break;
+	}
+	for (; done < count; ++done)
+		pcg32_srandom_r(&rngs[done], seed, firstStream + done);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include "RNGEngines.h"
+
+// A keyed pseudo random permutation of [0, n). Any element can be calculated in O(1), without storing anything.
+//
+// A Feistel network is a bijection on [0, 2^bits) for any round function, where bits is enough to hold n.
+// Elements that land outside of [0, n) are put through the network again until they land inside. This is cycle walking,
+// and it is still a bijection, on [0, n). Past the minimum size, 2^bits is less than 2n, so that is less than 2 times through
+// on average.
+//
+// The two halves are unequal when bits is odd. Each round, the low half is hashed into the high half and then
+// the two halves swap places, so the widths alternate.
+//
+// Halves of only 1 or 2 bits can't make every permutation, no matter how many rounds there are, which showed up as
+// some elements landing in some places up to 10% too often. So there are at least c_minBits bits, even though
+// that means more cycle walking for small n. With that, and 8 rounds, where each of n = 2 to 130 elements
+// lands over a few hundred thousand seeds passes a chi squared test.
+class FeistelPermutation
+{
+public:
+	// n must be at least 1, or At never finds an element inside [0, n)
+	FeistelPermutation(uint64_t n, uint64_t seed)
+		: m_n(n)
+	{
+		m_bits = c_minBits;
+		while (m_bits < 64 && (1ull << m_bits) < n)
+			m_bits++;
+
+		for (int round = 0; round < c_rounds; ++round)
+			m_keys[round] = SplitMix64Hash(seed + (round + 1) * 0x9e3779b97f4a7c15ull);
+	}
+
+	// index must be less than n
+	uint64_t At(uint64_t index) const
+	{
+		uint64_t x = index;
+		do
+		{
+			x = Encrypt(x);
+		}
+		while (x >= m_n);
+		return x;
+	}
+
+private:
+	static uint64_t Mask(int bits)
+	{
+		return bits >= 64 ? ~0ull : (1ull << bits) - 1;
+	}
+
+	uint64_t Encrypt(uint64_t x) const
+	{
+		int lowBits = m_bits / 2;
+		for (int round = 0; round < c_rounds; ++round)
+		{
+			int highBits = m_bits - lowBits;
+			uint64_t low = x & Mask(lowBits);
+			uint64_t high = (x >> lowBits) ^ (SplitMix64Hash(low ^ m_keys[round]) & Mask(highBits));
+			x = (low << highBits) | high;
+			lowBits = highBits;
+		}
+		return x;
+	}
+
+	static const int c_rounds = 8;
+	static const int c_minBits = 6;
+
+	uint64_t m_n;
+	int m_bits;
+	uint64_t m_keys[c_rounds];
+};
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SIMD.h"
+#include "PCG32xN.h"
+
+// Philox4x32-10 counter based rng, from "Parallel Random Numbers: As Easy as 1, 2, 3" by Salmon et al.
+// It has no sequential state. Every 128 bit counter is hashed with a 64 bit key into four 32 bit outputs.
+//
+// Here the key is the random seed, and the counter is (sampleIndex / 4, sequenceIndex), so sample i of
+// sequence s is a pure function of (seed, s, i) and can be calculated directly, in any order.
+
+static const uint32_t c_philoxM0 = 0xD2511F53;
+static const uint32_t c_philoxM1 = 0xCD9E8D57;
+static const uint32_t c_philoxW0 = 0x9E3779B9;
+static const uint32_t c_philoxW1 = 0xBB67AE85;
+static const int c_philoxRounds = 10;
+
+inline void Philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+{
+	uint32_t x0 = counter[0], x1 = counter[1], x2 = counter[2], x3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	for (int round = 0; round < c_philoxRounds; ++round)
+	{
+		uint64_t product0 = (uint64_t)c_philoxM0 * x0;
+		uint64_t product1 = (uint64_t)c_philoxM1 * x2;
+		x0 = (uint32_t)(product1 >> 32) ^ x1 ^ k0;
+		x1 = (uint32_t)product1;
+		x2 = (uint32_t)(product0 >> 32) ^ x3 ^ k1;
+		x3 = (uint32_t)product0;
+		k0 += c_philoxW0;
+		k1 += c_philoxW1;
+	}
+	out[0] = x0;
+	out[1] = x1;
+	out[2] = x2;
+	out[3] = x3;
+}
+
+struct PhiloxKey
+{
+	PhiloxKey(uint64_t seed, uint64_t sequenceIndex)
+	{
+		key[0] = (uint32_t)seed;
+		key[1] = (uint32_t)(seed >> 32);
+		sequence[0] = (uint32_t)sequenceIndex;
+		sequence[1] = (uint32_t)(sequenceIndex >> 32);
+	}
+
+	void Block(uint64_t blockIndex, uint32_t out[4]) const
+	{
+		uint32_t counter[4] = { (uint32_t)blockIndex, (uint32_t)(blockIndex >> 32), sequence[0], sequence[1] };
+		Philox4x32(counter, key, out);
+	}
+
+	uint32_t key[2];
+	uint32_t sequence[2];
+};
+
+// Sample sampleIndex of a sequence, directly
+inline uint32_t PhiloxAt(const PhiloxKey& key, uint64_t sampleIndex)
+{
+	uint32_t block[4];
+	key.Block(sampleIndex / 4, block);
+	return block[sampleIndex % 4];
+}
+
+inline void PhiloxStore(uint32_t* out, uint32_t value)
+{
+	*out = value;
+}
+
+inline void PhiloxStore(float* out, uint32_t value)
+{
+	*out = U32ToFloat01(value);
+}
+
+// ================= AVX2: 8 counters, 32 samples at a time =================
+
+SIMD_TARGET_AVX2 inline void Philox_MulHiLo_AVX2(__m256i a, __m256i m, __m256i& hi, __m256i& lo)
+{
+	lo = _mm256_mullo_epi32(a, m);
+	__m256i even = _mm256_srli_epi64(_mm256_mul_epu32(a, m), 32);
+	__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+	hi = _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+SIMD_TARGET_AVX2 inline void PhiloxStore_AVX2(uint32_t* out, __m256i v)
+{
+	_mm256_storeu_si256((__m256i*)out, v);
+}
+
+SIMD_TARGET_AVX2 inline void PhiloxStore_AVX2(float* out, __m256i v)
+{
+	_mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(v, 8)), _mm256_set1_ps(1.0f / 16777216.0f)));
+}
+
+// Fills groupCount * 32 samples starting at block firstBlock
+template <typename T>
+SIMD_TARGET_AVX2 void PhiloxFill_AVX2(const PhiloxKey& key, uint64_t firstBlock, T* out, size_t groupCount)
+{
+	const __m256i m0 = _mm256_set1_epi32((int)c_philoxM0);
+	const __m256i m1 = _mm256_set1_epi32((int)c_philoxM1);
+	const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	for (size_t group = 0; group < groupCount; ++group)
+	{
+		// Blocks don't cross a 2^32 boundary in practice, but handle the carry into the high word anyway
+		uint64_t block = firstBlock + group * 8;
+		__m256i x0 = _mm256_add_epi32(_mm256_set1_epi32((int)(uint32_t)block), laneOffsets);
+		__m256i carry = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_set1_epi32((int)(uint32_t)block), _mm256_set1_epi32((int)0x80000000)), _mm256_xor_si256(x0, _mm256_set1_epi32((int)0x80000000)));
+		__m256i x1 = _mm256_sub_epi32(_mm256_set1_epi32((int)(uint32_t)(block >> 32)), carry);
+		__m256i x2 = _mm256_set1_epi32((int)key.sequence[0]);
+		__m256i x3 = _mm256_set1_epi32((int)key.sequence[1]);
+		uint32_t k0 = key.key[0], k1 = key.key[1];
+
+		for (int round = 0; round < c_philoxRounds; ++round)
+		{
+			__m256i hi0, lo0, hi1, lo1;
+			Philox_MulHiLo_AVX2(x0, m0, hi0, lo0);
+			Philox_MulHiLo_AVX2(x2, m1, hi1, lo1);
+			x0 = _mm256_xor_si256(_mm256_xor_si256(hi1, x1), _mm256_set1_epi32((int)k0));
+			x1 = lo1;
+			x2 = _mm256_xor_si256(_mm256_xor_si256(hi0, x3), _mm256_set1_epi32((int)k1));
+			x3 = lo0;
+			k0 += c_philoxW0;
+			k1 += c_philoxW1;
+		}
+
+		// Transpose from a register per output word, to the four words of each block in order
+		__m256i t0 = _mm256_unpacklo_epi32(x0, x1);
+		__m256i t1 = _mm256_unpackhi_epi32(x0, x1);
+		__m256i t2 = _mm256_unpacklo_epi32(x2, x3);
+		__m256i t3 = _mm256_unpackhi_epi32(x2, x3);
+		__m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+		__m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+		__m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+		__m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+		T* groupOut = &out[group * 32];
+		PhiloxStore_AVX2(&groupOut[0], _mm256_permute2x128_si256(u0, u1, 0x20));
+		PhiloxStore_AVX2(&groupOut[8], _mm256_permute2x128_si256(u2, u3, 0x20));
+		PhiloxStore_AVX2(&groupOut[16], _mm256_permute2x128_si256(u0, u1, 0x31));
+		PhiloxStore_AVX2(&groupOut[24], _mm256_permute2x128_si256(u2, u3, 0x31));
+	}
+}
+
+// ================= AVX-512: 16 counters, 64 samples at a time =================
+
+SIMD_TARGET_AVX512 inline void Philox_MulHiLo_AVX512(__m512i a, __m512i m, __m512i& hi, __m512i& lo)
+{
+	lo = _mm512_mullo_epi32(a, m);
+	__m512i even = _mm512_srli_epi64(_mm512_mul_epu32(a, m), 32);
+	__m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), m);
+	hi = _mm512_mask_blend_epi32(0xAAAA, even, odd);
+}
+
+SIMD_TARGET_AVX512 inline void PhiloxStore_AVX512(uint32_t* out, __m512i v)
+{
+	_mm512_storeu_si512((void*)out, v);
+}
+
+SIMD_TARGET_AVX512 inline void PhiloxStore_AVX512(float* out, __m512i v)
+{
+	_mm512_storeu_ps(out, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(v, 8)), _mm512_set1_ps(1.0f / 16777216.0f)));
+}
+
+template <typename T>
+SIMD_TARGET_AVX512 void PhiloxFill_AVX512(const PhiloxKey& key, uint64_t firstBlock, T* out, size_t groupCount)
+{
+	const __m512i m0 = _mm512_set1_epi32((int)c_philoxM0);
+	const __m512i m1 = _mm512_set1_epi32((int)c_philoxM1);
+	const __m512i laneOffsets = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+	for (size_t group = 0; group < groupCount; ++group)
+	{
+		uint64_t block = firstBlock + group * 16;
+		__m512i blockLo = _mm512_set1_epi32((int)(uint32_t)block);
+		__m512i x0 = _mm512_add_epi32(blockLo, laneOffsets);
+		__mmask16 carry = _mm512_cmplt_epu32_mask(x0, blockLo);
+		__m512i x1 = _mm512_mask_add_epi32(_mm512_set1_epi32((int)(uint32_t)(block >> 32)), carry, _mm512_set1_epi32((int)(uint32_t)(block >> 32)), _mm512_set1_epi32(1));
+		__m512i x2 = _mm512_set1_epi32((int)key.sequence[0]);
+		__m512i x3 = _mm512_set1_epi32((int)key.sequence[1]);
+		uint32_t k0 = key.key[0], k1 = key.key[1];
+
+		for (int round = 0; round < c_philoxRounds; ++round)
+		{
+			__m512i hi0, lo0, hi1, lo1;
+			Philox_MulHiLo_AVX512(x0, m0, hi0, lo0);
+			Philox_MulHiLo_AVX512(x2, m1, hi1, lo1);
+			x0 = _mm512_ternarylogic_epi32(hi1, x1, _mm512_set1_epi32((int)k0), 0x96);
+			x1 = lo1;
+			x2 = _mm512_ternarylogic_epi32(hi0, x3, _mm512_set1_epi32((int)k1), 0x96);
+			x3 = lo0;
+			k0 += c_philoxW0;
+			k1 += c_philoxW1;
+		}
+
+		// Transpose within 128 bit lanes, so u[k] holds blocks k, k+4, k+8, k+12, then gather the 128 bit lanes in block order
+		__m512i t0 = _mm512_unpacklo_epi32(x0, x1);
+		__m512i t1 = _mm512_unpackhi_epi32(x0, x1);
+		__m512i t2 = _mm512_unpacklo_epi32(x2, x3);
+		__m512i t3 = _mm512_unpackhi_epi32(x2, x3);
+		__m512i u0 = _mm512_unpacklo_epi64(t0, t2);
+		__m512i u1 = _mm512_unpackhi_epi64(t0, t2);
+		__m512i u2 = _mm512_unpacklo_epi64(t1, t3);
+		__m512i u3 = _mm512_unpackhi_epi64(t1, t3);
+		__m512i a = _mm512_shuffle_i32x4(u0, u1, 0x44);
+		__m512i b = _mm512_shuffle_i32x4(u2, u3, 0x44);
+		__m512i c = _mm512_shuffle_i32x4(u0, u1, 0xEE);
+		__m512i d = _mm512_shuffle_i32x4(u2, u3, 0xEE);
+		T* groupOut = &out[group * 64];
+		PhiloxStore_AVX512(&groupOut[0], _mm512_shuffle_i32x4(a, b, 0x88));
+		PhiloxStore_AVX512(&groupOut[16], _mm512_shuffle_i32x4(a, b, 0xDD));
+		PhiloxStore_AVX512(&groupOut[32], _mm512_shuffle_i32x4(c, d, 0x88));
+		PhiloxStore_AVX512(&groupOut[48], _mm512_shuffle_i32x4(c, d, 0xDD));
+	}
+}
+
+// ================= Dispatch =================
+
+// Fills out with samples [firstSample, firstSample + count) of the sequence.
+// T is uint32_t for raw output, or float for [0,1) floats.
+template <typename T>
+void PhiloxFill(const PhiloxKey& key, uint64_t firstSample, T* out, size_t count)
+{
+	// Scalar until the start of a block
+	while (count > 0 && (firstSample % 4) != 0)
+	{
+		PhiloxStore(out++, PhiloxAt(key, firstSample++));
+		count--;
+	}
+
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512:
+		{
+			size_t groupCount = count / 64;
+			if (groupCount > 0)
+				PhiloxFill_AVX512(key, firstSample / 4, out, groupCount);
+			done = groupCount * 64;
+			break;
+		}
+		case SIMDLevel::AVX2:
+		{
+			size_t groupCount = count / 32;
+			if (groupCount > 0)
+				PhiloxFill_AVX2(key, firstSample / 4, out, groupCount);
+			done = groupCount * 32;
+			break;
+		}
+		default: break;
+	}
+
+	for (size_t i = done; i < count; i += 4)
+	{
+		uint32_t block[4];
+		key.Block((firstSample + i) / 4, block);
+		for (size_t j = 0; j < 4 && i + j < count; ++j)
+			PhiloxStore(&out[i + j], block[j]);
+	}
+}
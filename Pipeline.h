@@ -0,0 +1,261 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include "FilteredNoiseStream.h"
+
+// Sequences made of stages: a source, then things like filtering, CDF remapping and stratifying.
+// The samples go through every stage a chunk at a time, in place in the output, before the next chunk starts.
+// A chunk is c_pipelineChunkSize samples, so it stays in L1 from the first stage to the last, and the output is only
+// passed over once. Stage state, like filter history, lives in the stages.
+//
+// A stage is a struct with a nested template <typename T> class Stage, so that a pipeline can make floats or doubles.
+// Stage<T> has:
+//   Stage(numSamples, sequenceIndex)
+//   Prime(before) - for stages that need input before their first output, like filter history.
+//                   PipelinePull(before, values, count) gets that input from the stages before this one.
+//   Apply(chunk)  - does the stage to a chunk, in place.
+// The first stage is the source. It writes new values, instead of changing the ones there.
+
+static const size_t c_pipelineChunkSize = 256;
+
+template <typename T>
+struct PipelineChunk
+{
+	T* values;
+	const uint64_t* strata;  // which stratum each sample goes in, or null for in order: sample i is in stratum index + i
+	uint64_t index;          // the index in the sequence of the first sample
+	size_t count;
+};
+
+// Runs count samples through the stages before a stage that is priming
+template <typename BEFORE, typename T>
+void PipelinePull(BEFORE& before, T* values, size_t count)
+{
+	for (size_t done = 0; done < count; done += c_pipelineChunkSize)
+	{
+		PipelineChunk<T> chunk = { &values[done], nullptr, 0, std::min(c_pipelineChunkSize, count - done) };
+		before.Pull(chunk);
+	}
+}
+
+// Nothing comes before the source
+template <typename T>
+struct PipelineStart
+{
+	void Pull(PipelineChunk<T>&)
+	{
+	}
+};
+
+// The stages, applied in order
+template <typename T, typename... STAGES>
+class PipelineStages
+{
+public:
+	PipelineStages(size_t, uint64_t)
+	{
+	}
+
+	template <typename BEFORE>
+	void Prime(BEFORE&)
+	{
+	}
+
+	void Apply(PipelineChunk<T>&)
+	{
+	}
+};
+
+template <typename T, typename STAGE, typename... REST>
+class PipelineStages<T, STAGE, REST...>
+{
+public:
+	PipelineStages(size_t numSamples, uint64_t sequenceIndex)
+		: m_stage(numSamples, sequenceIndex)
+		, m_rest(numSamples, sequenceIndex)
+	{
+	}
+
+	// Primes this stage from the stages before it, and then the rest of them from those and this one
+	template <typename BEFORE>
+	void Prime(BEFORE& before)
+	{
+		m_stage.Prime(before);
+		Through<BEFORE> through = { before, m_stage };
+		m_rest.Prime(through);
+	}
+
+	void Apply(PipelineChunk<T>& chunk)
+	{
+		m_stage.Apply(chunk);
+		m_rest.Apply(chunk);
+	}
+
+private:
+	typedef typename STAGE::template Stage<T> StageType;
+
+	template <typename BEFORE>
+	struct Through
+	{
+		BEFORE& before;
+		StageType& stage;
+
+		void Pull(PipelineChunk<T>& chunk)
+		{
+			before.Pull(chunk);
+			stage.Apply(chunk);
+		}
+	};
+
+	StageType m_stage;
+	PipelineStages<T, REST...> m_rest;
+};
+
+template <typename T, typename... STAGES>
+class Pipeline
+{
+public:
+	Pipeline(size_t numSamples, uint64_t sequenceIndex)
+		: m_stages(numSamples, sequenceIndex)
+	{
+		PipelineStart<T> start;
+		m_stages.Prime(start);
+	}
+
+	void Generate(T* out, size_t count)
+	{
+		for (size_t done = 0; done < count; done += c_pipelineChunkSize)
+		{
+			PipelineChunk<T> chunk = { &out[done], nullptr, m_index, std::min(c_pipelineChunkSize, count - done) };
+			m_stages.Apply(chunk);
+			m_index += chunk.count;
+		}
+	}
+
+private:
+	PipelineStages<T, STAGES...> m_stages;
+	uint64_t m_index = 0;
+};
+
+// ================= Stages =================
+
+// Moves each value in [0,1] into its stratum, one of numSamples equal width ones. 0 samples is treated as 1 stratum.
+struct Stage_Stratify
+{
+	template <typename T>
+	class Stage
+	{
+	public:
+		Stage(size_t numSamples, uint64_t)
+			: m_numSamples(std::max<size_t>(numSamples, 1))
+		{
+		}
+
+		template <typename BEFORE>
+		void Prime(BEFORE&)
+		{
+		}
+
+		void Apply(PipelineChunk<T>& chunk)
+		{
+			T numSamples = T(m_numSamples);
+			if (chunk.strata)
+			{
+				for (size_t i = 0; i < chunk.count; ++i)
+					chunk.values[i] = (T(chunk.strata[i]) + chunk.values[i]) / numSamples;
+			}
+			else
+			{
+				for (size_t i = 0; i < chunk.count; ++i)
+					chunk.values[i] = (T(chunk.index + i) + chunk.values[i]) / numSamples;
+			}
+		}
+
+	private:
+		size_t m_numSamples;
+	};
+};
+
+// The filter part of a FilteredNoiseStreamT, see FilteredNoiseStream.h. Gives the same values, before the CDF.
+// Its history starts as the first values in, in the same order as FilteredNoiseStreamT's constructor.
+template <typename FILTER>
+struct Stage_Filter
+{
+	template <typename T>
+	class Stage
+	{
+	public:
+		Stage(size_t, uint64_t)
+		{
+		}
+
+		template <typename BEFORE>
+		void Prime(BEFORE& before)
+		{
+			PipelinePull(before, m_lastValues, c_historySize);
+		}
+
+		void Apply(PipelineChunk<T>& chunk)
+		{
+			T whiteNoise[c_pipelineChunkSize + c_historySize];
+			for (int i = 0; i < c_historySize; ++i)
+				whiteNoise[i] = m_lastValues[c_historySize - 1 - i];
+			std::copy(chunk.values, chunk.values + chunk.count, &whiteNoise[c_historySize]);
+
+			NoiseFIR<FILTER::c_xTapCount>(whiteNoise, chunk.values, chunk.count, FILTER::XTaps());
+
+			if (FILTER::c_yTapCount > 0)
+			{
+				const float* yTaps = FILTER::YTaps();
+				for (size_t i = 0; i < chunk.count; ++i)
+				{
+					T& y = chunk.values[i];
+					for (int tap = 0; tap < FILTER::c_yTapCount; ++tap)
+						y = MulThenAdd(m_lastOutputs[tap], T(yTaps[tap]), y);
+					for (int tap = FILTER::c_yTapCount - 1; tap > 0; --tap)
+						m_lastOutputs[tap] = m_lastOutputs[tap - 1];
+					m_lastOutputs[0] = y;
+				}
+			}
+
+			for (int i = 0; i < c_historySize; ++i)
+				m_lastValues[i] = whiteNoise[c_historySize + chunk.count - 1 - i];
+		}
+
+	private:
+		static const int c_historySize = FILTER::c_xTapCount - 1;
+
+		T m_lastValues[c_historySize > 0 ? c_historySize : 1] = {};
+		T m_lastOutputs[FILTER::c_yTapCount > 0 ? FILTER::c_yTapCount : 1] = {};
+	};
+};
+
+// Makes the output of Stage_Filter<FILTER> uniform, with its NoiseCDF, or a table of it if CDF_TABLE_SIZE isn't 0
+template <typename FILTER, size_t CDF_TABLE_SIZE = 0>
+struct Stage_NoiseCDF
+{
+	template <typename T>
+	class Stage
+	{
+	public:
+		Stage(size_t, uint64_t)
+			: m_cdf(&FilterCDF<FILTER, CDF_TABLE_SIZE>::Get())
+		{
+		}
+
+		template <typename BEFORE>
+		void Prime(BEFORE&)
+		{
+		}
+
+		void Apply(PipelineChunk<T>& chunk)
+		{
+			EvaluateNoiseCDF(chunk.values, chunk.values, chunk.count, *m_cdf);
+		}
+
+	private:
+		const typename FilterCDF<FILTER, CDF_TABLE_SIZE>::Type* m_cdf;
+	};
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "SIMD.h"
+
+// Running sums of [0,1] floats, in 16.48 fixed point.
+// Each value is rounded to a multiple of 2^-48 first, which is less than a float's precision for anything over 2^-25.
+// After that the sums are integer adds, which are exact, so the SIMD scans give the same bits as adding one at a time.
+// Sums can go up to 2^16.
+// Values below 0 are clamped to 0, since a negative one would wrap around to a huge unsigned value. So are NaNs.
+//
+// The rounding adds 2^52 to x * 2^48 in double, which rounds it to an integer, and that integer is the low bits of the double.
+// x * 2^48 is exact, so it doesn't matter whether the compiler fuses the multiply and add.
+
+static const int c_prefixSumFractionBits = 48;
+
+inline uint64_t ToPrefixSumFixed(float x)
+{
+	// The same as max_ps(x, 0), which the SIMD scans use
+	x = x > 0.0f ? x : 0.0f;
+	double d = double(x) * double(uint64_t(1) << c_prefixSumFractionBits) + 4503599627370496.0;
+	uint64_t bits;
+	memcpy(&bits, &d, sizeof(bits));
+	return bits - 0x4330000000000000ull;
+}
+
+// ================= SIMD =================
+// Each block is scanned in registers, shifting the partial sums up a lane, then two, (then four), and adding.
+// The sum so far is then added to all of them, and the last lane is the sum for the next block.
+
+SIMD_TARGET_AVX2 inline size_t PrefixSums_AVX2(const float* in, uint64_t* out, size_t count, uint64_t& sum)
+{
+	const __m256d scaleV = _mm256_set1_pd(double(uint64_t(1) << c_prefixSumFractionBits));
+	const __m256d magicV = _mm256_set1_pd(4503599627370496.0);
+	const __m256i magicBitsV = _mm256_set1_epi64x(0x4330000000000000ll);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i sumV = _mm256_set1_epi64x((long long)sum);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 clamped = _mm_max_ps(_mm_loadu_ps(&in[i]), _mm_setzero_ps());
+		__m256d x = _mm256_add_pd(_mm256_mul_pd(_mm256_cvtps_pd(clamped), scaleV), magicV);
+		__m256i sums = _mm256_sub_epi64(_mm256_castpd_si256(x), magicBitsV);
+		sums = _mm256_add_epi64(sums, _mm256_blend_epi32(_mm256_permute4x64_epi64(sums, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+		sums = _mm256_add_epi64(sums, _mm256_blend_epi32(_mm256_permute4x64_epi64(sums, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+		sums = _mm256_add_epi64(sums, sumV);
+		_mm256_storeu_si256((__m256i*)&out[i], sums);
+		sumV = _mm256_permute4x64_epi64(sums, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+	sum = (uint64_t)_mm256_extract_epi64(sumV, 0);
+	return i;
+}
+
+SIMD_TARGET_AVX512 inline size_t PrefixSums_AVX512(const float* in, uint64_t* out, size_t count, uint64_t& sum)
+{
+	const __m512d scaleV = _mm512_set1_pd(double(uint64_t(1) << c_prefixSumFractionBits));
+	const __m512d magicV = _mm512_set1_pd(4503599627370496.0);
+	const __m512i magicBitsV = _mm512_set1_epi64(0x4330000000000000ll);
+	const __m512i zero = _mm512_setzero_si512();
+	const __m512i lastLaneV = _mm512_set1_epi64(7);
+	__m512i sumV = _mm512_set1_epi64((long long)sum);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 clamped = _mm256_max_ps(_mm256_loadu_ps(&in[i]), _mm256_setzero_ps());
+		__m512d x = _mm512_add_pd(_mm512_mul_pd(_mm512_cvtps_pd(clamped), scaleV), magicV);
+		__m512i sums = _mm512_sub_epi64(_mm512_castpd_si512(x), magicBitsV);
+		sums = _mm512_add_epi64(sums, _mm512_alignr_epi64(sums, zero, 7));
+		sums = _mm512_add_epi64(sums, _mm512_alignr_epi64(sums, zero, 6));
+		sums = _mm512_add_epi64(sums, _mm512_alignr_epi64(sums, zero, 4));
+		sums = _mm512_add_epi64(sums, sumV);
+		_mm512_storeu_si512((void*)&out[i], sums);
+		sumV = _mm512_permutexvar_epi64(lastLaneV, sums);
+	}
+	if (i > 0)
+		sum = out[i - 1];
+	return i;
+}
+
+// ================= Dispatch =================
+
+// out[i] is sum plus in[0] through in[i]. Returns the sum of all of them, for the next call.
+inline uint64_t PrefixSums(const float* in, uint64_t* out, size_t count, uint64_t sum)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512: done = PrefixSums_AVX512(in, out, count, sum); break;
+		case SIMDLevel::AVX2: done = PrefixSums_AVX2(in, out, count, sum); break;
+		default: break;
+	}
+	for (size_t i = done; i < count; ++i)
+	{
+		sum += ToPrefixSumFixed(in[i]);
+		out[i] = sum;
+	}
+	return sum;
+}
@@ -0,0 +1,374 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "pcg/pcg_basic.h"
+#include "PCG32xN.h"
+#include "Philox.h"
+
+// White noise engines. Each one is constructed from (seed, sequenceIndex) and continues its stream through:
+//   Fill(out, count) - fills a block of uint32_t raw output, or [0,1) floats.
+//                      Also uint64_t raw output, or [0,1) doubles, for when 32 bits isn't enough.
+//   NextU32()        - a single raw 32 bit value.
+//   NextU64()        - a single raw 64 bit value. The high 32 bits are what NextU32() would have returned.
+//   Discard<T>(count) - skips what Fill() would use to make count samples of type T. O(log count) or better,
+//                      except for xoshiro256+, which steps through them.
+// The engines that make 64 bits at a time use the high 32 bits as a 32 bit sample.
+// The engines that make 32 bits at a time use two in a row as a 64 bit sample, the first being the high bits.
+
+inline void StoreSample(uint32_t* out, uint32_t value)
+{
+	*out = value;
+}
+
+inline void StoreSample(float* out, uint32_t value)
+{
+	*out = U32ToFloat01(value);
+}
+
+// 53 bits, which is all a double can hold in [0,1)
+inline double U64ToDouble01(uint64_t x)
+{
+	return double(x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+inline void StoreSample64(uint32_t* out, uint64_t value)
+{
+	*out = (uint32_t)(value >> 32);
+}
+
+inline void StoreSample64(float* out, uint64_t value)
+{
+	*out = U32ToFloat01((uint32_t)(value >> 32));
+}
+
+inline void StoreSample64(uint64_t* out, uint64_t value)
+{
+	*out = value;
+}
+
+inline void StoreSample64(double* out, uint64_t value)
+{
+	*out = U64ToDouble01(value);
+}
+
+inline uint64_t SplitMix64Hash(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+// How many outputs the 32 bit engines use per sample of type T
+template <typename T>
+uint64_t U32sPerSample()
+{
+	return sizeof(T) / sizeof(uint32_t);
+}
+
+// A well mixed 64 bit starting state per sequence
+inline uint64_t SequenceSeed64(uint64_t seed, uint64_t sequenceIndex)
+{
+	return SplitMix64Hash(seed ^ SplitMix64Hash(sequenceIndex + 0x9e3779b97f4a7c15ull));
+}
+
+template <typename ENGINE, typename T>
+void FillFromU64(ENGINE& engine, T* out, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		StoreSample64(&out[i], engine.NextU64());
+}
+
+// For the 32 bit engines. Their block fill makes the 32 bit values, which are then paired up.
+template <typename ENGINE, typename T>
+void FillFromU32Pairs(ENGINE& engine, T* out, size_t count)
+{
+	static const size_t c_chunkSize = 256;
+	uint32_t values[c_chunkSize * 2];
+	for (size_t chunkStart = 0; chunkStart < count; chunkStart += c_chunkSize)
+	{
+		size_t chunkCount = (count - chunkStart < c_chunkSize) ? count - chunkStart : c_chunkSize;
+		engine.Fill(values, chunkCount * 2);
+		for (size_t i = 0; i < chunkCount; ++i)
+			StoreSample64(&out[chunkStart + i], ((uint64_t)values[i * 2] << 32) | values[i * 2 + 1]);
+	}
+}
+
+// Uses the multi-lane PCG32 for blocks
+class PCG32Engine
+{
+public:
+	PCG32Engine(const pcg32_random_t& rng)
+		: m_rng(rng)
+	{
+	}
+
+	PCG32Engine(uint64_t seed, uint64_t sequenceIndex)
+	{
+		pcg32_srandom_r(&m_rng, seed, sequenceIndex);
+	}
+
+	template <typename T>
+	void Fill(T* out, size_t count)
+	{
+		PCG32Fill(m_rng, out, count);
+	}
+
+	void Fill(uint64_t* out, size_t count)
+	{
+		FillFromU32Pairs(*this, out, count);
+	}
+
+	void Fill(double* out, size_t count)
+	{
+		FillFromU32Pairs(*this, out, count);
+	}
+
+	uint32_t NextU32()
+	{
+		return pcg32_random_r(&m_rng);
+	}
+
+	uint64_t NextU64()
+	{
+		uint64_t high = pcg32_random_r(&m_rng);
+		return (high << 32) | pcg32_random_r(&m_rng);
+	}
+
+	template <typename T>
+	void Discard(uint64_t count)
+	{
+		pcg32_advance_r(&m_rng, count * U32sPerSample<T>());
+	}
+
+private:
+	pcg32_random_t m_rng;
+};
+
+// 64 bit output from two pcg32 generators on different streams, one for the high 32 bits and one for the low 32 bits.
+// This is pcg32x2 from the pcg-c-basic demos. The real pcg64 needs 128 bit math, which MSVC doesn't have.
+class PCG64Engine
+{
+public:
+	PCG64Engine(uint64_t seed, uint64_t sequenceIndex)
+	{
+		// pcg32 drops the top bit of the stream, so the streams are 2*sequenceIndex and 2*sequenceIndex+1.
+		pcg32_srandom_r(&m_rng[0], seed, sequenceIndex * 2);
+		pcg32_srandom_r(&m_rng[1], SplitMix64Hash(seed), sequenceIndex * 2 + 1);
+	}
+
+	uint64_t NextU64()
+	{
+		uint64_t high = pcg32_random_r(&m_rng[0]);
+		return (high << 32) | pcg32_random_r(&m_rng[1]);
+	}
+
+	template <typename T>
+	void Fill(T* out, size_t count)
+	{
+		FillFromU64(*this, out, count);
+	}
+
+	uint32_t NextU32()
+	{
+		return (uint32_t)(NextU64() >> 32);
+	}
+
+	template <typename T>
+	void Discard(uint64_t count)
+	{
+		pcg32_advance_r(&m_rng[0], count);
+		pcg32_advance_r(&m_rng[1], count);
+	}
+
+private:
+	pcg32_random_t m_rng[2];
+};
+
+// Counter based, so it can also jump to any sample of the sequence in O(1), or calculate one directly with At().
+class PhiloxEngine
+{
+public:
+	PhiloxEngine(uint64_t seed, uint64_t sequenceIndex)
+		: m_key(seed, sequenceIndex)
+	{
+	}
+
+	template <typename T>
+	void Fill(T* out, size_t count)
+	{
+		PhiloxFill(m_key, m_index, out, count);
+		m_index += count;
+	}
+
+	void Fill(uint64_t* out, size_t count)
+	{
+		FillFromU32Pairs(*this, out, count);
+	}
+
+	void Fill(double* out, size_t count)
+	{
+		FillFromU32Pairs(*this, out, count);
+	}
+
+	uint32_t NextU32()
+	{
+		return PhiloxAt(m_key, m_index++);
+	}
+
+	uint64_t NextU64()
+	{
+		uint64_t high = PhiloxAt(m_key, m_index);
+		uint64_t low = PhiloxAt(m_key, m_index + 1);
+		m_index += 2;
+		return (high << 32) | low;
+	}
+
+	uint32_t At(uint64_t sampleIndex) const
+	{
+		return PhiloxAt(m_key, sampleIndex);
+	}
+
+	void Seek(uint64_t sampleIndex)
+	{
+		m_index = sampleIndex;
+	}
+
+	template <typename T>
+	void Discard(uint64_t count)
+	{
+		m_index += count * U32sPerSample<T>();
+	}
+
+private:
+	PhiloxKey m_key;
+	uint64_t m_index = 0;
+};
+
+// xoshiro256+ from https://prng.di.unimi.it/
+// The low bits are weak, which doesn't matter since only the high 32 are used.
+class Xoshiro256PlusEngine
+{
+public:
+	Xoshiro256PlusEngine(uint64_t seed, uint64_t sequenceIndex)
+	{
+		// The state is filled with splitmix64, as recommended
+		uint64_t x = SequenceSeed64(seed, sequenceIndex);
+		for (uint64_t& s : m_state)
+		{
+			x += 0x9e3779b97f4a7c15ull;
+			s = SplitMix64Hash(x);
+		}
+	}
+
+	uint64_t NextU64()
+	{
+		uint64_t result = m_state[0] + m_state[3];
+		uint64_t t = m_state[1] << 17;
+		m_state[2] ^= m_state[0];
+		m_state[3] ^= m_state[1];
+		m_state[1] ^= m_state[2];
+		m_state[0] ^= m_state[3];
+		m_state[2] ^= t;
+		m_state[3] = (m_state[3] << 45) | (m_state[3] >> 19);
+		return result;
+	}
+
+	template <typename T>
+	void Fill(T* out, size_t count)
+	{
+		FillFromU64(*this, out, count);
+	}
+
+	uint32_t NextU32()
+	{
+		return (uint32_t)(NextU64() >> 32);
+	}
+
+	// xoshiro256+ can only jump 2^128 or 2^192 steps quickly, so this steps through them
+	template <typename T>
+	void Discard(uint64_t count)
+	{
+		for (uint64_t i = 0; i < count; ++i)
+			NextU64();
+	}
+
+private:
+	uint64_t m_state[4];
+};
+
+// wyrand from https://github.com/wangyi-fudan/wyhash
+class WyRandEngine
+{
+public:
+	WyRandEngine(uint64_t seed, uint64_t sequenceIndex)
+		: m_state(SequenceSeed64(seed, sequenceIndex))
+	{
+	}
+
+	uint64_t NextU64()
+	{
+		m_state += 0xa0761d6478bd642full;
+		uint64_t lo, hi;
+		Mul128(m_state, m_state ^ 0xe7037ed1a0b428dbull, lo, hi);
+		return lo ^ hi;
+	}
+
+	template <typename T>
+	void Fill(T* out, size_t count)
+	{
+		FillFromU64(*this, out, count);
+	}
+
+	uint32_t NextU32()
+	{
+		return (uint32_t)(NextU64() >> 32);
+	}
+
+	// The state is a counter
+	template <typename T>
+	void Discard(uint64_t count)
+	{
+		m_state += count * 0xa0761d6478bd642full;
+	}
+
+private:
+	uint64_t m_state;
+};
+
+// splitmix64, a Weyl sequence put through a hash
+class SplitMix64Engine
+{
+public:
+	SplitMix64Engine(uint64_t seed, uint64_t sequenceIndex)
+		: m_state(SequenceSeed64(seed, sequenceIndex))
+	{
+	}
+
+	uint64_t NextU64()
+	{
+		m_state += 0x9e3779b97f4a7c15ull;
+		return SplitMix64Hash(m_state);
+	}
+
+	template <typename T>
+	void Fill(T* out, size_t count)
+	{
+		FillFromU64(*this, out, count);
+	}
+
+	uint32_t NextU32()
+	{
+		return (uint32_t)(NextU64() >> 32);
+	}
+
+	// The state is a counter
+	template <typename T>
+	void Discard(uint64_t count)
+	{
+		m_state += count * 0x9e3779b97f4a7c15ull;
+	}
+
+private:
+	uint64_t m_state;
+};
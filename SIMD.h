@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdint.h>
+#include <immintrin.h>
+
+// MSVC lets any function use any intrinsic, but gcc and clang need the instruction set enabled per function.
+// Functions tagged with these must only be called after checking ActiveSIMDLevel().
+// The SIMD paths need to give the same bits as the scalar code, so gcc is told not to fuse multiplies and adds into FMAs.
+// MSVC and clang only fuse intrinsics when asked to. The scalar side uses MulThenAdd(), below.
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#elif defined(__clang__)
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx2,fma,avx512f,avx512dq,avx512bw,avx512vl")))
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma"), optimize("fp-contract=off")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx2,fma,avx512f,avx512dq,avx512bw,avx512vl"), optimize("fp-contract=off")))
+#endif
+
+// x must not be 0
+inline unsigned int CountTrailingZeros(uint32_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return (unsigned int)index;
+#else
+	return (unsigned int)__builtin_ctz(x);
+#endif
+}
+
+inline unsigned int PopCount64(uint64_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	return (unsigned int)__popcnt64(x);
+#else
+	return (unsigned int)__builtin_popcountll(x);
+#endif
+}
+
+// The full 128 bit product of two 64 bit numbers
+inline void Mul128(uint64_t a, uint64_t b, uint64_t& lo, uint64_t& hi)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	lo = _umul128(a, b, &hi);
+#else
+	__uint128_t product = (__uint128_t)a * b;
+	lo = (uint64_t)product;
+	hi = (uint64_t)(product >> 64);
+#endif
+}
+
+// a * b + c, rounded after the multiply and again after the add, like the SIMD kernels do it.
+// Compilers can fuse a plain a * b + c into an FMA wherever FMA is enabled: gcc does by default, with -march=native,
+// and clang with -ffp-contract=fast. The empty asm hides the product from the compiler, so that can't happen whatever
+// the flags are. MSVC only fuses with /fp:fast or /fp:contract, and the project is /fp:precise.
+template <typename T>
+inline T MulThenAdd(T a, T b, T c)
+{
+	T product = a * b;
+#if !defined(_MSC_VER) || defined(__clang__)
+	__asm__("" : "+x"(product));
+#endif
+	return product + c;
+}
+
+enum class SIMDLevel
+{
+	Scalar,
+	AVX2,   // 8 float lanes
+	AVX512  // 16 float lanes. Needs F, DQ, BW and VL.
+};
+
+inline SIMDLevel DetectSIMDLevel()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	if (maxLeaf < 7)
+		return SIMDLevel::Scalar;
+
+	// The OS has to save the ymm (and zmm) registers for us to be able to use them
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool fma = (info[2] & (1 << 12)) != 0;
+	if (!osxsave)
+		return SIMDLevel::Scalar;
+	unsigned long long xcr0 = _xgetbv(0);
+
+	__cpuidex(info, 7, 0);
+	bool avx2 = (info[1] & (1 << 5)) != 0;
+	bool avx512 =
+		(info[1] & (1 << 16)) != 0 &&  // F
+		(info[1] & (1 << 17)) != 0 &&  // DQ
+		(info[1] & (1 << 30)) != 0 &&  // BW
+		(info[1] & (1 << 31)) != 0;    // VL
+
+	if (avx512 && fma && avx2 && (xcr0 & 0xE6) == 0xE6)
+		return SIMDLevel::AVX512;
+	if (avx2 && fma && (xcr0 & 0x6) == 0x6)
+		return SIMDLevel::AVX2;
+	return SIMDLevel::Scalar;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return SIMDLevel::AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return SIMDLevel::AVX2;
+	return SIMDLevel::Scalar;
+#endif
+}
+
+// The code path the SIMD kernels dispatch to. Detected once, but can be assigned to, to force a slower path.
+// All paths give bit identical results.
+inline SIMDLevel& ActiveSIMDLevel()
+{
+	static SIMDLevel level = DetectSIMDLevel();
+	return level;
+}
+
+inline const char* SIMDLevelName(SIMDLevel level)
+{
+	switch (level)
+	{
+		case SIMDLevel::AVX2: return "AVX2";
+		case SIMDLevel::AVX512: return "AVX-512";
+		default: return "Scalar";
+	}
+}
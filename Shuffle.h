@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include "SIMD.h"
+
+// Fisher-Yates shuffling, with several bounded random numbers made from each 64 bit random number.
+// From "Batched Ranged Random Integer Generation" by Nevin Brackett-Rozinsky and Daniel Lemire, 2024.
+//
+// Lemire's multiply-shift turns a random r into a roll of an n sided die as the high 64 bits of r * n.
+// The low 64 bits are left over, and are random enough to roll the next die the same way, and so on.
+// The rolls are exactly uniform as long as the leftover after the last die is at least 2^64 mod (product of the sides),
+// otherwise they are all rolled again. That only happens with chance below product / 2^64, so the product of the
+// sides in a batch is kept below c_maxDiceProduct, which makes it less than 1 in 256.
+
+static const int c_maxDicePerBatch = 8;
+static const uint64_t c_maxDiceProduct = 1ull << 56;
+
+// Rolls count dice with the given number of sides from a single 64 bit random number, and returns the leftover
+inline uint64_t RollDice(uint64_t random, const uint64_t* sides, int count, uint64_t* rolls)
+{
+	for (int i = 0; i < count; ++i)
+		Mul128(random, sides[i], random, rolls[i]);
+	return random;
+}
+
+// Does the next batch of steps of a forward Fisher-Yates shuffle, starting at position first.
+// Returns how many positions are now final. ENGINE needs NextU64(), like the ones in RNGEngines.h.
+template <typename T, typename ENGINE>
+size_t ShuffleBatch(T* values, size_t count, size_t first, ENGINE& engine)
+{
+	if (first + 1 >= count)
+		return count - first;
+
+	// Position first + i swaps with one of the count - first - i positions from there on.
+	// Take as many of those as fit, but always at least one.
+	uint64_t sides[c_maxDicePerBatch];
+	uint64_t product = count - first;
+	sides[0] = product;
+	int diceCount = 1;
+	while (diceCount < c_maxDicePerBatch && first + diceCount + 1 < count)
+	{
+		uint64_t nextSides = count - first - diceCount;
+		uint64_t lo, hi;
+		Mul128(product, nextSides, lo, hi);
+		if (hi != 0 || lo > c_maxDiceProduct)
+			break;
+		product = lo;
+		sides[diceCount++] = nextSides;
+	}
+
+	uint64_t rolls[c_maxDicePerBatch];
+	uint64_t leftover = RollDice(engine.NextU64(), sides, diceCount, rolls);
+	if (leftover < product)
+	{
+		uint64_t threshold = (0 - product) % product;
+		while (leftover < threshold)
+			leftover = RollDice(engine.NextU64(), sides, diceCount, rolls);
+	}
+
+	for (int i = 0; i < diceCount; ++i)
+		std::swap(values[first + i], values[first + i + rolls[i]]);
+	return diceCount;
+}
+
+// Shuffles all count values
+template <typename T, typename ENGINE>
+void BatchedShuffle(T* values, size_t count, ENGINE& engine)
+{
+	for (size_t first = 0; first < count;)
+		first += ShuffleBatch(values, count, first, engine);
+}
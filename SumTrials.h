@@ -0,0 +1,197 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "pcg/pcg_basic.h"
+#include "PCG32xN.h"
+#include "SIMD.h"
+
+// SumTest trials on white noise, a register of them at a time: each lane is a trial with its own PCG32, and sums its
+// [0,1) floats until it gets to >= 1.0. The states, sums and counts are structure of arrays, one lane per trial.
+// A lane that is done is masked off, and stops changing, and the block goes on until every lane is done.
+//
+// A lane makes the same numbers as its rng would by itself, and adds them in the same order in float, so the counts are
+// the same as doing the trials one at a time. A block generates as many numbers per lane as its longest trial needs,
+// rounded up to even.
+//
+// The rng step is a 64 bit multiply, which is slow, and each step needs the one before it. So each lane has two rngs, one
+// for its even numbers and one for its odd numbers, and both jump two steps at a time, which lets the multiplies overlap.
+// Two steps is state * A^2 + inc * (A + 1).
+//
+// On one thread that is about 10x as fast as a LazySequence per trial with AVX-512, but only about 5x with AVX2. AVX2 has no
+// 64 bit multiply, so each one is three 32 bit multiplies, and the rng steps are most of its time.
+
+// ================= AVX2: 8 trials =================
+// The SIMD kernels do whole blocks of 8 or 16 trials, and return how many they did. The dispatch does the rest.
+
+// The states and increments of four rngs, in lane order
+SIMD_TARGET_AVX2 inline void LoadPCG32s_AVX2(const pcg32_random_t* rngs, __m256i& states, __m256i& incs)
+{
+	__m256i a = _mm256_loadu_si256((const __m256i*)&rngs[0]);
+	__m256i b = _mm256_loadu_si256((const __m256i*)&rngs[2]);
+	states = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+	incs = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+// The [0,1) floats of 8 rngs
+SIMD_TARGET_AVX2 inline __m256 PCG32sToFloats_AVX2(__m256i states0, __m256i states1)
+{
+	const __m256i packIndex = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+	__m256i out0 = _mm256_permutevar8x32_epi32(PCG32xN_Output_AVX2(states0), packIndex);
+	__m256i out1 = _mm256_permutevar8x32_epi32(PCG32xN_Output_AVX2(states1), packIndex);
+	__m256i bits = _mm256_permute2x128_si256(out0, out1, 0x20);
+	return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+}
+
+SIMD_TARGET_AVX2 inline size_t SumTrials_AVX2(const pcg32_random_t* rngs, uint32_t* counts, size_t count, size_t& generated)
+{
+	const __m256i multV = _mm256_set1_epi64x((long long)c_pcg32Multiplier);
+	const __m256i mult2V = _mm256_set1_epi64x((long long)(c_pcg32Multiplier * c_pcg32Multiplier));
+	const __m256i multPlusOneV = _mm256_set1_epi64x((long long)(c_pcg32Multiplier + 1));
+	const __m256 oneV = _mm256_set1_ps(1.0f);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i even0, inc0, even1, inc1;
+		LoadPCG32s_AVX2(&rngs[i], even0, inc0);
+		LoadPCG32s_AVX2(&rngs[i + 4], even1, inc1);
+		__m256i odd0 = _mm256_add_epi64(PCG32xN_Mul64_AVX2(even0, multV), inc0);
+		__m256i odd1 = _mm256_add_epi64(PCG32xN_Mul64_AVX2(even1, multV), inc1);
+		inc0 = PCG32xN_Mul64_AVX2(inc0, multPlusOneV);
+		inc1 = PCG32xN_Mul64_AVX2(inc1, multPlusOneV);
+
+		__m256 sum = _mm256_setzero_ps();
+		__m256i countV = _mm256_setzero_si256();
+		__m256 active = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		size_t steps = 0;
+		do
+		{
+			__m256 evenX = PCG32sToFloats_AVX2(even0, even1);
+			__m256 oddX = PCG32sToFloats_AVX2(odd0, odd1);
+
+			// Done lanes add 0, and active lanes are -1, so subtracting them counts them
+			sum = _mm256_add_ps(sum, _mm256_and_ps(evenX, active));
+			countV = _mm256_sub_epi32(countV, _mm256_castps_si256(active));
+			active = _mm256_and_ps(active, _mm256_cmp_ps(sum, oneV, _CMP_LT_OQ));
+			sum = _mm256_add_ps(sum, _mm256_and_ps(oddX, active));
+			countV = _mm256_sub_epi32(countV, _mm256_castps_si256(active));
+			active = _mm256_and_ps(active, _mm256_cmp_ps(sum, oneV, _CMP_LT_OQ));
+
+			even0 = _mm256_add_epi64(PCG32xN_Mul64_AVX2(even0, mult2V), inc0);
+			even1 = _mm256_add_epi64(PCG32xN_Mul64_AVX2(even1, mult2V), inc1);
+			odd0 = _mm256_add_epi64(PCG32xN_Mul64_AVX2(odd0, mult2V), inc0);
+			odd1 = _mm256_add_epi64(PCG32xN_Mul64_AVX2(odd1, mult2V), inc1);
+			steps += 2;
+		}
+		while (_mm256_movemask_ps(active) != 0);
+
+		_mm256_storeu_si256((__m256i*)&counts[i], countV);
+		generated += steps * 8;
+	}
+	return i;
+}
+
+// ================= AVX-512: 16 trials =================
+
+// The [0,1) floats of 16 rngs.
+// The high 32 bits of the xorshifted state are the top 5 bits of the state, which is the rotation. So one shuffle gets
+// all 16 xorshifteds, and another gets all 16 rotations.
+SIMD_TARGET_AVX512 inline __m512 PCG32sToFloats_AVX512(__m512i states0, __m512i states1)
+{
+	const __m512i lowIndex = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+	const __m512i highIndex = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+	__m512i xorshifted0 = _mm512_srli_epi64(_mm512_xor_si512(_mm512_srli_epi64(states0, 18), states0), 27);
+	__m512i xorshifted1 = _mm512_srli_epi64(_mm512_xor_si512(_mm512_srli_epi64(states1, 18), states1), 27);
+	__m512i bits = _mm512_rorv_epi32(_mm512_permutex2var_epi32(xorshifted0, lowIndex, xorshifted1), _mm512_permutex2var_epi32(xorshifted0, highIndex, xorshifted1));
+	return _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(bits, 8)), _mm512_set1_ps(1.0f / 16777216.0f));
+}
+
+SIMD_TARGET_AVX512 inline size_t SumTrials_AVX512(const pcg32_random_t* rngs, uint32_t* counts, size_t count, size_t& generated)
+{
+	const __m512i multV = _mm512_set1_epi64((long long)c_pcg32Multiplier);
+	const __m512i mult2V = _mm512_set1_epi64((long long)(c_pcg32Multiplier * c_pcg32Multiplier));
+	const __m512i multPlusOneV = _mm512_set1_epi64((long long)(c_pcg32Multiplier + 1));
+	const __m512i stateIndex = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+	const __m512i incIndex = _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15);
+	const __m512 oneV = _mm512_set1_ps(1.0f);
+	const __m512i countOneV = _mm512_set1_epi32(1);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m512i a = _mm512_loadu_si512((const void*)&rngs[i]);
+		__m512i b = _mm512_loadu_si512((const void*)&rngs[i + 4]);
+		__m512i c = _mm512_loadu_si512((const void*)&rngs[i + 8]);
+		__m512i d = _mm512_loadu_si512((const void*)&rngs[i + 12]);
+		__m512i even0 = _mm512_permutex2var_epi64(a, stateIndex, b);
+		__m512i inc0 = _mm512_permutex2var_epi64(a, incIndex, b);
+		__m512i even1 = _mm512_permutex2var_epi64(c, stateIndex, d);
+		__m512i inc1 = _mm512_permutex2var_epi64(c, incIndex, d);
+		__m512i odd0 = _mm512_add_epi64(_mm512_mullo_epi64(even0, multV), inc0);
+		__m512i odd1 = _mm512_add_epi64(_mm512_mullo_epi64(even1, multV), inc1);
+		inc0 = _mm512_mullo_epi64(inc0, multPlusOneV);
+		inc1 = _mm512_mullo_epi64(inc1, multPlusOneV);
+
+		__m512 sum = _mm512_setzero_ps();
+		__m512i countV = _mm512_setzero_si512();
+		__mmask16 active = 0xFFFF;
+		size_t steps = 0;
+		do
+		{
+			__m512 evenX = PCG32sToFloats_AVX512(even0, even1);
+			__m512 oddX = PCG32sToFloats_AVX512(odd0, odd1);
+
+			sum = _mm512_mask_add_ps(sum, active, sum, evenX);
+			countV = _mm512_mask_add_epi32(countV, active, countV, countOneV);
+			active = _mm512_mask_cmp_ps_mask(active, sum, oneV, _CMP_LT_OQ);
+			sum = _mm512_mask_add_ps(sum, active, sum, oddX);
+			countV = _mm512_mask_add_epi32(countV, active, countV, countOneV);
+			active = _mm512_mask_cmp_ps_mask(active, sum, oneV, _CMP_LT_OQ);
+
+			even0 = _mm512_add_epi64(_mm512_mullo_epi64(even0, mult2V), inc0);
+			even1 = _mm512_add_epi64(_mm512_mullo_epi64(even1, mult2V), inc1);
+			odd0 = _mm512_add_epi64(_mm512_mullo_epi64(odd0, mult2V), inc0);
+			odd1 = _mm512_add_epi64(_mm512_mullo_epi64(odd1, mult2V), inc1);
+			steps += 2;
+		}
+		while (active != 0);
+
+		_mm512_storeu_si512((void*)&counts[i], countV);
+		generated += steps * 16;
+	}
+	return i;
+}
+
+// ================= Dispatch =================
+
+inline uint32_t SumTrialScalar(pcg32_random_t rng)
+{
+	float value = 0.0f;
+	uint32_t count = 0;
+	do
+	{
+		value += U32ToFloat01(pcg32_random_r(&rng));
+		count++;
+	}
+	while (value < 1.0f);
+	return count;
+}
+
+// counts[i] is how many numbers from rngs[i] it takes to sum to >= 1.0. The rngs aren't advanced.
+// Returns how many numbers were generated, in all.
+inline size_t SumTrials(const pcg32_random_t* rngs, uint32_t* counts, size_t count)
+{
+	size_t generated = 0;
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512: done = SumTrials_AVX512(rngs, counts, count, generated); break;
+		case SIMDLevel::AVX2: done = SumTrials_AVX2(rngs, counts, count, generated); break;
+		default: break;
+	}
+	for (size_t i = done; i < count; ++i)
+	{
+		counts[i] = SumTrialScalar(rngs[i]);
+		generated += counts[i];
+	}
+	return generated;
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SIMD.h"
+#include "RNGEngines.h"
+
+// Weyl sequences, also known as Kronecker or additive recurrence sequences: element i is frac(offset + i * alpha).
+// Done in 0.64 fixed point, where the wrapping of a 64 bit add is the frac, so there is no fmod and no precision drift.
+// Element i can be calculated directly, so blocks can be made in SIMD, and any element can be jumped to.
+// A float sample is the top 24 bits, and a double sample is the top 53 bits.
+
+// The fractional part of some irrational numbers, in 0.64 fixed point.
+// They are all odd, so the sequence visits all 2^64 values before repeating.
+static const uint64_t c_weylGoldenRatio = 0x9E3779B97F4A7C15ull;  // 1/phi = 0.6180339887...
+static const uint64_t c_weylSqrt2 = 0x6A09E667F3BCC909ull;        // sqrt(2) - 1 = 0.4142135623...
+static const uint64_t c_weylPlastic = 0xC13FA9A902A6328Full;      // 1/rho = 0.7548776662..., where rho^3 = rho + 1
+
+// ================= AVX2: 8 samples at a time =================
+// The 64 bit state of samples 0-3 is in v0, and 4-7 is in v1.
+
+SIMD_TARGET_AVX2 inline __m256i WeylHigh32_AVX2(__m256i v0, __m256i v1)
+{
+	const __m256i highHalves = _mm256_setr_epi32(1, 3, 5, 7, 1, 3, 5, 7);
+	return _mm256_permute2x128_si256(_mm256_permutevar8x32_epi32(v0, highHalves), _mm256_permutevar8x32_epi32(v1, highHalves), 0x20);
+}
+
+// There is no 64 bit integer to double conversion in AVX2. The top 53 bits are converted as two 32 bit halves,
+// by putting each in the mantissa of a double with a known exponent and subtracting the exponent back out.
+// Each step is exact, so this gives the same double as the scalar conversion.
+SIMD_TARGET_AVX2 inline __m256d WeylDouble01_AVX2(__m256i v)
+{
+	__m256i x = _mm256_srli_epi64(v, 11);
+	__m256d high = _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(x, 32), _mm256_castpd_si256(_mm256_set1_pd(19342813113834066795298816.0))));  // 2^84
+	__m256d low = _mm256_castsi256_pd(_mm256_blend_epi32(x, _mm256_castpd_si256(_mm256_set1_pd(4503599627370496.0)), 0xAA));  // 2^52
+	__m256d value = _mm256_add_pd(_mm256_sub_pd(high, _mm256_set1_pd(19342813113834066795298816.0 + 4503599627370496.0)), low);
+	return _mm256_mul_pd(value, _mm256_set1_pd(1.0 / 9007199254740992.0));
+}
+
+SIMD_TARGET_AVX2 inline void WeylStore_AVX2(uint32_t* out, __m256i v0, __m256i v1)
+{
+	_mm256_storeu_si256((__m256i*)out, WeylHigh32_AVX2(v0, v1));
+}
+
+SIMD_TARGET_AVX2 inline void WeylStore_AVX2(float* out, __m256i v0, __m256i v1)
+{
+	_mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(WeylHigh32_AVX2(v0, v1), 8)), _mm256_set1_ps(1.0f / 16777216.0f)));
+}
+
+SIMD_TARGET_AVX2 inline void WeylStore_AVX2(uint64_t* out, __m256i v0, __m256i v1)
+{
+	_mm256_storeu_si256((__m256i*)&out[0], v0);
+	_mm256_storeu_si256((__m256i*)&out[4], v1);
+}
+
+SIMD_TARGET_AVX2 inline void WeylStore_AVX2(double* out, __m256i v0, __m256i v1)
+{
+	_mm256_storeu_pd(&out[0], WeylDouble01_AVX2(v0));
+	_mm256_storeu_pd(&out[4], WeylDouble01_AVX2(v1));
+}
+
+template <typename T>
+SIMD_TARGET_AVX2 void WeylFill_AVX2(uint64_t start, uint64_t alpha, T* out, size_t blockCount)
+{
+	__m256i v0 = _mm256_add_epi64(_mm256_set1_epi64x((long long)start), _mm256_setr_epi64x(0, (long long)alpha, (long long)(alpha * 2), (long long)(alpha * 3)));
+	__m256i v1 = _mm256_add_epi64(v0, _mm256_set1_epi64x((long long)(alpha * 4)));
+	const __m256i stepV = _mm256_set1_epi64x((long long)(alpha * 8));
+	for (size_t block = 0; block < blockCount; ++block)
+	{
+		WeylStore_AVX2(&out[block * 8], v0, v1);
+		v0 = _mm256_add_epi64(v0, stepV);
+		v1 = _mm256_add_epi64(v1, stepV);
+	}
+}
+
+// ================= AVX-512: 16 samples at a time =================
+// The 64 bit state of samples 0-7 is in v0, and 8-15 is in v1.
+
+SIMD_TARGET_AVX512 inline __m512i WeylHigh32_AVX512(__m512i v0, __m512i v1)
+{
+	__m256i high0 = _mm512_cvtepi64_epi32(_mm512_srli_epi64(v0, 32));
+	__m256i high1 = _mm512_cvtepi64_epi32(_mm512_srli_epi64(v1, 32));
+	return _mm512_inserti64x4(_mm512_castsi256_si512(high0), high1, 1);
+}
+
+SIMD_TARGET_AVX512 inline void WeylStore_AVX512(uint32_t* out, __m512i v0, __m512i v1)
+{
+	_mm512_storeu_si512((void*)out, WeylHigh32_AVX512(v0, v1));
+}
+
+SIMD_TARGET_AVX512 inline void WeylStore_AVX512(float* out, __m512i v0, __m512i v1)
+{
+	_mm512_storeu_ps(out, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(WeylHigh32_AVX512(v0, v1), 8)), _mm512_set1_ps(1.0f / 16777216.0f)));
+}
+
+SIMD_TARGET_AVX512 inline void WeylStore_AVX512(uint64_t* out, __m512i v0, __m512i v1)
+{
+	_mm512_storeu_si512((void*)&out[0], v0);
+	_mm512_storeu_si512((void*)&out[8], v1);
+}
+
+SIMD_TARGET_AVX512 inline void WeylStore_AVX512(double* out, __m512i v0, __m512i v1)
+{
+	const __m512d scaleV = _mm512_set1_pd(1.0 / 9007199254740992.0);
+	_mm512_storeu_pd(&out[0], _mm512_mul_pd(_mm512_cvtepu64_pd(_mm512_srli_epi64(v0, 11)), scaleV));
+	_mm512_storeu_pd(&out[8], _mm512_mul_pd(_mm512_cvtepu64_pd(_mm512_srli_epi64(v1, 11)), scaleV));
+}
+
+template <typename T>
+SIMD_TARGET_AVX512 void WeylFill_AVX512(uint64_t start, uint64_t alpha, T* out, size_t blockCount)
+{
+	const __m512i laneIndex = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+	__m512i v0 = _mm512_add_epi64(_mm512_set1_epi64((long long)start), _mm512_mullo_epi64(laneIndex, _mm512_set1_epi64((long long)alpha)));
+	__m512i v1 = _mm512_add_epi64(v0, _mm512_set1_epi64((long long)(alpha * 8)));
+	const __m512i stepV = _mm512_set1_epi64((long long)(alpha * 16));
+	for (size_t block = 0; block < blockCount; ++block)
+	{
+		WeylStore_AVX512(&out[block * 16], v0, v1);
+		v0 = _mm512_add_epi64(v0, stepV);
+		v1 = _mm512_add_epi64(v1, stepV);
+	}
+}
+
+// ================= Dispatch =================
+
+// Fills out with count elements of the Weyl sequence that starts at start and steps by alpha.
+// T is uint32_t or uint64_t for the raw fixed point value, or float or double for [0,1).
+template <typename T>
+void WeylFill(uint64_t start, uint64_t alpha, T* out, size_t count)
+{
+	size_t done = 0;
+	switch (ActiveSIMDLevel())
+	{
+		case SIMDLevel::AVX512:
+		{
+			size_t blockCount = count / 16;
+			if (blockCount > 0)
+				WeylFill_AVX512(start, alpha, out, blockCount);
+			done = blockCount * 16;
+			break;
+		}
+		case SIMDLevel::AVX2:
+		{
+			size_t blockCount = count / 8;
+			if (blockCount > 0)
+				WeylFill_AVX2(start, alpha, out, blockCount);
+			done = blockCount * 8;
+			break;
+		}
+		default: break;
+	}
+	for (size_t i = done; i < count; ++i)
+		StoreSample64(&out[i], start + i * alpha);
+}
+
+// A Weyl sequence that continues from where it left off, like the white noise engines do
+class WeylSequence
+{
+public:
+	WeylSequence(uint64_t offset, uint64_t alpha)
+		: m_offset(offset)
+		, m_alpha(alpha)
+	{
+	}
+
+	template <typename T>
+	void Fill(T* out, size_t count)
+	{
+		WeylFill(At(m_index), m_alpha, out, count);
+		m_index += count;
+	}
+
+	// Element index, as 0.64 fixed point
+	uint64_t At(uint64_t index) const
+	{
+		return m_offset + index * m_alpha;
+	}
+
+	void Seek(uint64_t index)
+	{
+		m_index = index;
+	}
+
+private:
+	uint64_t m_offset;
+	uint64_t m_alpha;
+	uint64_t m_index = 0;
+};
+
+// A Weyl sequence with a fixed alpha, so it can be made from just a seed, like the sequences in LowDiscrepancy.h
+template <uint64_t ALPHA>
+class KroneckerSequence : public WeylSequence
+{
+public:
+	KroneckerSequence(uint64_t offset)
+		: WeylSequence(offset, ALPHA)
+	{
+	}
+};
@@ -1,30 +1,126 @@
 #include <stdio.h>
 #include <random>
 #include <vector>
+#include <memory>
+#include <algorithm>
 #include "pcg/pcg_basic.h"
+#include "PCG32xN.h"
+#include "Buckets.h"
+#include "RNGEngines.h"
+#include "Weyl.h"
+#include "LowDiscrepancy.h"
+#include "Permutation.h"
+#include "Shuffle.h"
 #include <omp.h>
 #include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
 #include "BlueNoiseStream.h"
+#include "CDFTable.h"
+#include "Pipeline.h"
+#include "Candidates.h"
+#include "PrefixSum.h"
+#include "SumTrials.h"
+#include <type_traits>
+#include <limits>
 
 // ============== TEST SETTINGS ==============
 
 #define DETERMINISTIC() false
 
+// If true, each sequence's rng is a 2^32 long section of one pcg stream, reached by jumping ahead.
+// If false, each sequence seeds its own pcg stream.
+#define SEED_BY_JUMPING() false
+
+// The engine the sequences get their white noise from. See RNGEngines.h.
+// PCG32Engine, PCG64Engine, PhiloxEngine, Xoshiro256PlusEngine, WyRandEngine or SplitMix64Engine.
+// With PhiloxEngine, every sample is a pure function of (seed, sequenceIndex, sampleIndex).
+#define WHITE_NOISE_ENGINE() PCG32Engine
+
+// If true, the shuffled sequences are shuffled with a Feistel permutation, one element at a time as they are asked for.
+// If false, the whole sequence is generated and then shuffled with a Fisher-Yates shuffle, with batched dice rolls.
+// The tests only use the path picked here. The shuffle benchmarks time both. The permutation needs no scratch buffer,
+// but 8 rounds of hashing per element is slower than generating everything: the sum test took 4x as long with it.
+#define SHUFFLE_BY_PERMUTATION() false
+
+// If true, Better Blue Noise 2 takes its random bits 64 at a time from WHITE_NOISE_ENGINE().
+// If false, it uses the original super tiny PRNG, which makes one bit per step.
+#define APPLETON_BITS_FROM_ENGINE() true
+
+// If not 0, the noise sequences are made uniform with a lookup table of this many entries, with linear interpolation,
+// instead of with the exact triangle CDF (Blue Noise, Red Noise) or the CDF polynomials (the FilteredNoiseStreamT ones).
+// See CDFTable.h. 256 to 65536 are reasonable, the benchmarks show the error and speed of each.
+#define CDF_TABLE_SIZE() 0
+
+// If true, the lottery test is also run with the coverage estimator, see LotteryCoverageTest, to compare them
+#define LOTTERY_COVERAGE_TEST() true
+
+// If true, the white noise sum test does its trials SumTrials lanes at a time, see SumTestLanes
+#define SUM_TEST_LANES() true
+
+// If true, runs the benchmarks instead of the tests
+#define RUN_BENCHMARKS() false
+
+// If true, runs the candidate cutoff sweep instead of the tests, and writes the curves to c_cutoffSweepFileName.
+// See CandidateCutoffSweepTest.
+#define RUN_CUTOFF_SWEEP() false
+
+// If true, runs the lottery curves instead of the tests, and writes them to c_lotteryCurveFileName.
+// See LotteryCurveTest.
+#define RUN_LOTTERY_CURVES() false
+
+// If true, runs the sum curves instead of the tests, and writes them to c_sumCurveFileName.
+// See SumCurveTest.
+#define RUN_SUM_CURVES() false
+
+// If true, runs the checks instead of the tests, at every SIMD level the machine has. See RunChecks.
+// The exit code is the number of checks that failed.
+#define RUN_CHECKS() false
+
+// Up to c_maxFloatBuckets, the lottery test uses float samples and 32 bit tickets. Past it, double samples and 64 bit tickets.
+// This can go past 2^32.
 static const size_t c_lotteryWinFrequency = 10000;
 
 static const size_t c_lotteryTestCountOuter = 1000;
 static const size_t c_lotteryTestCountInner = 1000;
 
+static const size_t c_lotteryMinBlockSize = 16;
+static const size_t c_lotteryMaxBlockSize = 256;
+
+// Each coverage trial is worth a lot of regular ones, so it needs far fewer
+static const size_t c_lotteryCoverageTestCountOuter = 1000;
+static const size_t c_lotteryCoverageTestCountInner = 10;
+
+static const size_t c_lotteryCurveTestCountOuter = 100;
+static const size_t c_lotteryCurveTestCountInner = 100;
+static const char* c_lotteryCurveFileName = "LotteryCurves.csv";
+
 static const size_t c_sumTestCountOuter = 10000;
 static const size_t c_sumTestCountInner = 10000;
 
+// A sequence that runs out before getting to the sum is made again, twice as long, up to this many times
+static const int c_sumTestMaxDoublings = 20;
+
+// The thresholds are every 1/2^c_sumCurveStepBits up to c_sumCurveMaxThreshold.
+// Being powers of two, they are exact in the fixed point sums of PrefixSum.h.
+static const size_t c_sumCurveTestCountOuter = 100;
+static const size_t c_sumCurveTestCountInner = 10000;
+static const size_t c_sumCurveMaxThreshold = 16;
+static const int c_sumCurveStepBits = 6;
+static const char* c_sumCurveFileName = "SumCurves.csv";
+
 static const size_t c_candidateTestCountOuter = 10000;
 static const size_t c_candidateTestCountInner = 1000;
 static const size_t c_candidateCount = 1000;
+static const size_t c_candidateChunkSize = 256;
+
+static const size_t c_cutoffSweepTestCountOuter = 100;
+static const size_t c_cutoffSweepTestCountInner = 1000;
+static const char* c_cutoffSweepFileName = "CandidateCutoffs.csv";
 
 // ================== OTHER ==================
 
-static const float c_goldenRatioConjugate = 0.61803398875f;
 static uint64_t g_randomSeed = 0;
 
 float Lerp(float A, float B, float t)
@@ -32,59 +128,128 @@ float Lerp(float A, float B, float t)
 	return A * (1.0f - t) + B * t;
 }
 
-// =================== RNG ===================
+// ================= SEEDING =================
+
+// Jumps along a stream to get a per sequence rng.
+// The jump is (the low 32 bits of sequenceIndex) * 2^32 steps. The LCG for each power of two stride is precomputed,
+// so a jump is one multiply add per set bit.
+// A 2^64 step jump is the full period, which is no jump at all, so only 2^32 sequences fit in a stream. The high 32 bits
+// of sequenceIndex pick the stream instead, so sequences 2^32 apart don't get the same numbers.
+// A stride of n steps is state * A^n + inc * (A^(n-1) + ... + A + 1). The sums don't depend on inc, so they work for every stream.
+struct SequenceJumper
+{
+	void Init(uint64_t seed)
+	{
+		pcg32_srandom_r(&m_base, seed, 0);
+
+		// Double a single step 32 times to get the LCG for a 2^32 step stride, then keep doubling for the larger strides
+		uint64_t mult = c_pcg32Multiplier;
+		uint64_t sum = 1;
+		for (int i = 0; i < 64; ++i)
+		{
+			if (i >= 32)
+			{
+				m_strideMult[i - 32] = mult;
+				m_strideSum[i - 32] = sum;
+			}
+			sum = (mult + 1) * sum;
+			mult *= mult;
+		}
+	}
+
+	void Seed(pcg32_random_t& rng, uint64_t sequenceIndex) const
+	{
+		// inc has to stay odd, and m_base.inc is odd
+		rng.inc = m_base.inc ^ ((sequenceIndex >> 32) << 1);
+		rng.state = m_base.state;
+		uint32_t jump = (uint32_t)sequenceIndex;
+		for (int bit = 0; bit < 32 && (jump >> bit) != 0; ++bit)
+		{
+			// branchless, since the bits are random enough to defeat the branch predictor
+			uint64_t mask = 0 - uint64_t((jump >> bit) & 1);
+			uint64_t mult = (m_strideMult[bit] & mask) | (1 & ~mask);
+			rng.state = rng.state * mult + rng.inc * (m_strideSum[bit] & mask);
+		}
+	}
+
+	// From the rng for a sequence to the rng for the next one: one 2^32 step stride.
+	// Not for going from a multiple of 2^32 minus one to the next, which changes stream.
+	void Next(pcg32_random_t& rng) const
+	{
+		rng.state = rng.state * m_strideMult[0] + rng.inc * m_strideSum[0];
+	}
 
-float PCGRandomFloat01(pcg32_random_t& rng)
+	pcg32_random_t m_base;
+	uint64_t m_strideMult[32] = {};
+	uint64_t m_strideSum[32] = {};
+};
+
+static SequenceJumper g_sequenceJumper;
+
+void SeedSequenceRNG_Stream(pcg32_random_t& rng, uint64_t sequenceIndex)
 {
-	return ldexpf((float)pcg32_random_r(&rng), -32);
+	pcg32_srandom_r(&rng, g_randomSeed, sequenceIndex);
 }
 
-template <typename T>
-T MapFloat(float f, T min, T max)
+void SeedSequenceRNG_Jump(pcg32_random_t& rng, uint64_t sequenceIndex)
 {
-	T range = max - min;
-	return min + std::min(size_t(f * float(range + 1)), range);
+	g_sequenceJumper.Seed(rng, sequenceIndex);
 }
 
-std::vector<float> Generate_WhiteNoise(size_t numSamples, uint64_t sequenceIndex)
+void SeedSequenceRNG(pcg32_random_t& rng, uint64_t sequenceIndex)
 {
-	pcg32_random_t rng;
-	pcg32_srandom_r(&rng, g_randomSeed, sequenceIndex);
-	std::vector<float> ret(numSamples);
-	for (float& v : ret)
-		v = PCGRandomFloat01(rng);
-	return ret;
+#if SEED_BY_JUMPING()
+	SeedSequenceRNG_Jump(rng, sequenceIndex);
+#else
+	SeedSequenceRNG_Stream(rng, sequenceIndex);
+#endif
 }
 
-std::vector<float> Generate_Stratified(size_t numSamples, uint64_t sequenceIndex)
+// SeedSequenceRNG for count sequences in a row, from firstSequenceIndex. For trials done a block at a time.
+void SeedSequenceRNGs(pcg32_random_t* rngs, uint64_t firstSequenceIndex, size_t count)
 {
-	pcg32_random_t rng;
-	pcg32_srandom_r(&rng, g_randomSeed, sequenceIndex);
-	std::vector<float> ret(numSamples);
-	for (size_t index = 0; index < numSamples; ++index)
-		ret[index] = (float(index) + PCGRandomFloat01(rng)) / float(numSamples);
-	return ret;
+	if (count == 0)
+		return;
+#if SEED_BY_JUMPING()
+	g_sequenceJumper.Seed(rngs[0], firstSequenceIndex);
+	for (size_t i = 1; i < count; ++i)
+	{
+		uint64_t sequenceIndex = firstSequenceIndex + i;
+		if ((uint32_t)sequenceIndex == 0)
+		{
+			g_sequenceJumper.Seed(rngs[i], sequenceIndex);
+			continue;
+		}
+		rngs[i] = rngs[i - 1];
+		g_sequenceJumper.Next(rngs[i]);
+	}
+#else
+	PCG32SeedStreams(rngs, g_randomSeed, firstSequenceIndex, count);
+#endif
 }
 
-std::vector<float> Generate_RegularOffset(size_t numSamples, uint64_t sequenceIndex)
+// =================== RNG ===================
+
+typedef WHITE_NOISE_ENGINE() WhiteNoiseEngine;
+
+// The engine for a sequence
+template <typename ENGINE>
+ENGINE SequenceEngine(uint64_t sequenceIndex)
 {
-	float offset = Generate_WhiteNoise(1, sequenceIndex)[0];
-	std::vector<float> ret(numSamples);
-	for (size_t index = 0; index < numSamples; ++index)
-		ret[index] = (float(index) + offset) / float(numSamples);
-	return ret;
+	return ENGINE(g_randomSeed, sequenceIndex);
 }
 
-std::vector<float> Generate_GoldenRatio(size_t numSamples, uint64_t sequenceIndex)
+// PCG can also be seeded by jumping along one stream, see SEED_BY_JUMPING()
+template <>
+PCG32Engine SequenceEngine<PCG32Engine>(uint64_t sequenceIndex)
 {
-	std::vector<float> ret(numSamples);
-	ret[0] = Generate_WhiteNoise(1, sequenceIndex)[0];
-	for (size_t i = 1; i < numSamples; ++i)
-		ret[i] = std::fmod(ret[i - 1] + c_goldenRatioConjugate, 1.0f);
-	return ret;
+	pcg32_random_t rng;
+	SeedSequenceRNG(rng, sequenceIndex);
+	return PCG32Engine(rng);
 }
 
-float LinearToUniform(float x)
+template <typename T>
+constexpr T LinearToUniform(T x)
 {
 	// PDF In:  y = 2x
 	// PDF Out: y = 1
@@ -92,118 +257,639 @@ float LinearToUniform(float x)
 	return x * x;
 }
 
-float TriangleToUniform(float x)
+template <typename T>
+constexpr T TriangleToUniform(T x)
 {
-	if (x < 0.5f)
+	if (x < T(0.5))
 	{
-		x = LinearToUniform(x * 2.0f) / 2.0f;
+		x = LinearToUniform(x * T(2)) / T(2);
 	}
 	else
 	{
-		x = 1.0f - x;
-		x = LinearToUniform(x * 2.0f) / 2.0f;
-		x = 1.0f - x;
+		x = T(1) - x;
+		x = LinearToUniform(x * T(2)) / T(2);
+		x = T(1) - x;
 	}
 	return x;
 }
 
-std::vector<float> Generate_BlueNoise(size_t numSamples, uint64_t sequenceIndex)
+// TriangleToUniform as a function object, to make a CDFTable of it at compile time
+struct TriangleCDF
+{
+	constexpr double operator()(double x) const { return TriangleToUniform(x); }
+};
+
+template <size_t SIZE>
+const CDFTable<SIZE>& TriangleCDFTable()
+{
+	static constexpr CDFTable<SIZE> table{ TriangleCDF() };
+	return table;
+}
+
+// Makes triangle distributed values uniform, exactly or with a table, depending on CDF_TABLE_SIZE()
+template <typename T>
+void TrianglesToUniform(T* values, size_t count)
+{
+#if CDF_TABLE_SIZE()
+	EvaluateCDFTable(TriangleCDFTable<CDF_TABLE_SIZE()>(), values, values, count);
+#else
+	for (size_t i = 0; i < count; ++i)
+		values[i] = TriangleToUniform(values[i]);
+#endif
+}
+
+enum class ScratchBuffer
+{
+	Test,
+	Shuffle
+};
+
+// A buffer per thread, so the tests don't allocate once it has grown large enough.
+// Each use gets its own buffer so they don't stomp on each other.
+template <ScratchBuffer WHICH, typename T = float>
+T* ThreadScratchBuffer(size_t numSamples)
+{
+	thread_local std::vector<T> buffer;
+	if (buffer.size() < numSamples)
+		buffer.resize(numSamples);
+	return buffer.data();
+}
+
+// ================ SEQUENCES ================
+// Each sequence type is constructed from (numSamples, sequenceIndex) and then generates its samples in order,
+// any number at a time, through Generate(out, count). numSamples is how many samples the caller intends to use,
+// which stratified and regular offset need to know up front.
+// m_generated counts every sample computed, including ones computed up front.
+// The sequences that use white noise get it from ENGINE. The typedefs without the T use WhiteNoiseEngine.
+// Samples are float by default. The T template parameter can make them double instead, which is for when
+// 24 bits isn't enough. SampleType is the type of sample, and WithSample<U> is the same sequence with U samples.
+
+struct SequenceBase
+{
+	size_t m_generated = 0;
+};
+
+template <typename ENGINE, typename T = float>
+class Sequence_WhiteNoiseT : public SequenceBase
 {
-	std::vector<float> whiteNoise = Generate_WhiteNoise(numSamples + 1, sequenceIndex);
-	std::vector<float> ret(numSamples);
-	for (size_t i = 1; i < numSamples; ++i)
+public:
+	typedef T SampleType;
+	template <typename U> using WithSample = Sequence_WhiteNoiseT<ENGINE, U>;
+
+	Sequence_WhiteNoiseT(size_t, uint64_t sequenceIndex)
+		: m_engine(SequenceEngine<ENGINE>(sequenceIndex))
 	{
-		ret[i] = whiteNoise[i + 1] - whiteNoise[i];
-		ret[i] = (ret[i] + 1.0f) / 2.0f;
-		ret[i] = TriangleToUniform(ret[i]);
 	}
-	return ret;
-}
 
-std::vector<float> Generate_RedNoise(size_t numSamples, uint64_t sequenceIndex)
+	void Generate(T* out, size_t count)
+	{
+		m_engine.Fill(out, count);
+		m_generated += count;
+	}
+
+	// The raw rng output, for the integer bucket mapping
+	void GenerateU32(uint32_t* out, size_t count)
+	{
+		m_engine.Fill(out, count);
+		m_generated += count;
+	}
+
+	void GenerateU64(uint64_t* out, size_t count)
+	{
+		m_engine.Fill(out, count);
+		m_generated += count;
+	}
+
+private:
+	ENGINE m_engine;
+};
+
+// A sequence made of stages, see Pipeline.h. The first stage is the source. The samples go through all of the stages
+// a chunk at a time, in place in out, so there are no buffers in between them.
+template <typename T, typename... STAGES>
+class Sequence_PipelineT : public SequenceBase
 {
-	std::vector<float> whiteNoise = Generate_WhiteNoise(numSamples + 1, sequenceIndex);
-	std::vector<float> ret(numSamples);
-	for (size_t i = 1; i < numSamples; ++i)
+public:
+	typedef T SampleType;
+	template <typename U> using WithSample = Sequence_PipelineT<U, STAGES...>;
+
+	Sequence_PipelineT(size_t numSamples, uint64_t sequenceIndex)
+		: m_pipeline(numSamples, sequenceIndex)
 	{
-		ret[i] = whiteNoise[i + 1] + whiteNoise[i];
-		ret[i] = ret[i] / 2.0f;
-		ret[i] = TriangleToUniform(ret[i]);
 	}
-	return ret;
-}
 
-std::vector<float> Generate_BetterBlueNoise(size_t numSamples, uint64_t sequenceIndex)
+	void Generate(T* out, size_t count)
+	{
+		m_pipeline.Generate(out, count);
+		m_generated += count;
+	}
+
+private:
+	Pipeline<T, STAGES...> m_pipeline;
+};
+
+// The pipeline stages that need the sequence seeding. The general ones are in Pipeline.h.
+
+// Source: white noise from ENGINE
+template <typename ENGINE>
+struct Stage_WhiteNoise
 {
-	pcg32_random_t rng;
-	pcg32_srandom_r(&rng, g_randomSeed, sequenceIndex);
+	template <typename T>
+	class Stage
+	{
+	public:
+		Stage(size_t, uint64_t sequenceIndex)
+			: m_engine(SequenceEngine<ENGINE>(sequenceIndex))
+		{
+		}
 
-	BlueNoiseStreamPolynomial blueNoiseRNG(rng);
+		template <typename BEFORE>
+		void Prime(BEFORE&)
+		{
+		}
 
-	std::vector<float> ret(numSamples);
-	for (float& f : ret)
-		f = blueNoiseRNG.Next();
+		void Apply(PipelineChunk<T>& chunk)
+		{
+			m_engine.Fill(chunk.values, chunk.count);
+		}
 
-	return ret;
-}
+	private:
+		ENGINE m_engine;
+	};
+};
 
-std::vector<float> Generate_BetterBlueNoise2(size_t numSamples, uint64_t sequenceIndex)
+// Source: one white noise value, repeated
+template <typename ENGINE>
+struct Stage_RegularOffset
 {
-	pcg32_random_t rng;
-	pcg32_srandom_r(&rng, g_randomSeed, sequenceIndex);
+	template <typename T>
+	class Stage
+	{
+	public:
+		Stage(size_t, uint64_t sequenceIndex)
+		{
+			Sequence_WhiteNoiseT<ENGINE, T>(1, sequenceIndex).Generate(&m_offset, 1);
+		}
+
+		template <typename BEFORE>
+		void Prime(BEFORE&)
+		{
+		}
+
+		void Apply(PipelineChunk<T>& chunk)
+		{
+			std::fill(chunk.values, chunk.values + chunk.count, m_offset);
+		}
+
+	private:
+		T m_offset;
+	};
+};
+
+// Shuffles the strata without generating the whole sequence: sample i is in stratum Permutation(i).
+// Stratified has an independent white noise sample per stratum, so it doesn't matter which one goes with which stratum,
+// and this is the same as shuffling the whole sequence. Past numSamples it starts over, with the same permutation.
+// The permutation gets a different seed than the white noise, so they are independent.
+// 0 samples is treated as 1 stratum, like Stage_Stratify does.
+struct Stage_PermutedStrata
+{
+	template <typename T>
+	class Stage
+	{
+	public:
+		Stage(size_t numSamples, uint64_t sequenceIndex)
+			: m_permutation(std::max<size_t>(numSamples, 1), SequenceSeed64(~g_randomSeed, sequenceIndex))
+			, m_numSamples(std::max<size_t>(numSamples, 1))
+		{
+		}
 
-	BlueNoiseStreamAppleton blueNoiseRNG(pcg32_random_r(&rng));
+		template <typename BEFORE>
+		void Prime(BEFORE&)
+		{
+		}
+
+		void Apply(PipelineChunk<T>& chunk)
+		{
+			for (size_t i = 0; i < chunk.count; ++i)
+				m_strata[i] = m_permutation.At((chunk.index + i) % m_numSamples);
+			chunk.strata = m_strata;
+		}
 
-	std::vector<float> ret(numSamples);
-	for (float& f : ret)
-		f = blueNoiseRNG.Next();
+	private:
+		FeistelPermutation m_permutation;
+		size_t m_numSamples;
+		uint64_t m_strata[c_pipelineChunkSize];
+	};
+};
 
-	return ret;
-}
+template <typename ENGINE, typename T = float> using Sequence_StratifiedT = Sequence_PipelineT<T, Stage_WhiteNoise<ENGINE>, Stage_Stratify>;
+template <typename ENGINE, typename T = float> using Sequence_RegularOffsetT = Sequence_PipelineT<T, Stage_RegularOffset<ENGINE>, Stage_Stratify>;
 
-std::vector<float> Generate_BetterRedNoise(size_t numSamples, uint64_t sequenceIndex)
+// A deterministic sequence from Weyl.h or LowDiscrepancy.h, randomized per sequence with a seed from white noise.
+// For the additive recurrences, frac(offset + i * alpha), the seed is the offset.
+template <typename ENGINE, typename GENERATOR, typename T = float>
+class Sequence_LowDiscrepancyT : public SequenceBase
 {
-	pcg32_random_t rng;
-	pcg32_srandom_r(&rng, g_randomSeed, sequenceIndex);
+public:
+	typedef T SampleType;
+	template <typename U> using WithSample = Sequence_LowDiscrepancyT<ENGINE, GENERATOR, U>;
+
+	Sequence_LowDiscrepancyT(size_t, uint64_t sequenceIndex)
+		: m_generator(RandomSeed(sequenceIndex))
+	{
+	}
+
+	void Generate(T* out, size_t count)
+	{
+		m_generator.Fill(out, count);
+		m_generated += count;
+	}
+
+private:
+	static uint64_t RandomSeed(uint64_t sequenceIndex)
+	{
+		uint64_t seed;
+		Sequence_WhiteNoiseT<ENGINE>(1, sequenceIndex).GenerateU64(&seed, 1);
+		return seed;
+	}
+
+	GENERATOR m_generator;
+};
+
+template <typename ENGINE, typename T = float> using Sequence_GoldenRatioT = Sequence_LowDiscrepancyT<ENGINE, KroneckerSequence<c_weylGoldenRatio>, T>;
+template <typename ENGINE, typename T = float> using Sequence_Sqrt2T = Sequence_LowDiscrepancyT<ENGINE, KroneckerSequence<c_weylSqrt2>, T>;
+template <typename ENGINE, typename T = float> using Sequence_PlasticT = Sequence_LowDiscrepancyT<ENGINE, KroneckerSequence<c_weylPlastic>, T>;
+template <typename ENGINE, typename T = float> using Sequence_VanDerCorputT = Sequence_LowDiscrepancyT<ENGINE, VanDerCorputSequence, T>;
+template <typename ENGINE, typename T = float> using Sequence_SobolT = Sequence_LowDiscrepancyT<ENGINE, SobolSequence, T>;
+template <typename ENGINE, typename T = float> using Sequence_Halton3T = Sequence_LowDiscrepancyT<ENGINE, HaltonSequence<3>, T>;
+template <typename ENGINE, typename T = float> using Sequence_Halton5T = Sequence_LowDiscrepancyT<ENGINE, HaltonSequence<5>, T>;
+
+// Two tap filter: the average of each white noise value and the one before it, or half their difference plus 1/2 for blue.
+// That's triangle distributed. Sample 0 is always 0 and the very first white noise sample is skipped, as the original
+// versions of these did.
+template <bool BLUE>
+struct Stage_TwoTapFilter
+{
+	template <typename T>
+	class Stage
+	{
+	public:
+		Stage(size_t, uint64_t)
+		{
+		}
+
+		template <typename BEFORE>
+		void Prime(BEFORE& before)
+		{
+			T skipped;
+			PipelinePull(before, &skipped, 1);
+		}
+
+		void Apply(PipelineChunk<T>& chunk)
+		{
+			size_t start = 0;
+			if (m_first && chunk.count > 0)
+			{
+				m_first = false;
+				m_lastValue = chunk.values[0];
+				chunk.values[0] = T(0);
+				start = 1;
+			}
+
+			for (size_t i = start; i < chunk.count; ++i)
+			{
+				T value = chunk.values[i];
+				if (BLUE)
+					chunk.values[i] = (value - m_lastValue + T(1)) / T(2);
+				else
+					chunk.values[i] = (value + m_lastValue) / T(2);
+				m_lastValue = value;
+			}
+		}
+
+	private:
+		T m_lastValue = T(0);
+		bool m_first = true;
+	};
+};
+
+// Makes triangle distributed values uniform, see TrianglesToUniform
+struct Stage_TriangleCDF
+{
+	template <typename T>
+	class Stage
+	{
+	public:
+		Stage(size_t, uint64_t)
+		{
+		}
+
+		template <typename BEFORE>
+		void Prime(BEFORE&)
+		{
+		}
+
+		void Apply(PipelineChunk<T>& chunk)
+		{
+			TrianglesToUniform(chunk.values, chunk.count);
+		}
+	};
+};
+
+template <typename ENGINE, typename T = float> using Sequence_BlueNoiseT = Sequence_PipelineT<T, Stage_WhiteNoise<ENGINE>, Stage_TwoTapFilter<true>, Stage_TriangleCDF>;
+template <typename ENGINE, typename T = float> using Sequence_RedNoiseT = Sequence_PipelineT<T, Stage_WhiteNoise<ENGINE>, Stage_TwoTapFilter<false>, Stage_TriangleCDF>;
+
+// The filters are in BlueNoiseStream.h. These are the same as FilteredNoiseStreamT.
+template <typename ENGINE, typename FILTER, typename T = float> using Sequence_FilteredNoiseT = Sequence_PipelineT<T, Stage_WhiteNoise<ENGINE>, Stage_Filter<FILTER>, Stage_NoiseCDF<FILTER, CDF_TABLE_SIZE()>>;
+
+template <typename ENGINE, typename T = float> using Sequence_BetterBlueNoiseT = Sequence_FilteredNoiseT<ENGINE, BlueNoiseFilter, T>;
+template <typename ENGINE, typename T = float> using Sequence_BetterRedNoiseT = Sequence_FilteredNoiseT<ENGINE, RedNoiseFilter, T>;
+template <typename ENGINE, typename T = float> using Sequence_BlueNoise5TapT = Sequence_FilteredNoiseT<ENGINE, BlueNoiseFilter5, T>;
+template <typename ENGINE, typename T = float> using Sequence_RedNoiseIIRT = Sequence_FilteredNoiseT<ENGINE, RedNoiseFilterIIR, T>;
+
+template <typename ENGINE, typename T = float>
+class Sequence_BetterBlueNoise2T : public SequenceBase
+{
+public:
+	typedef T SampleType;
+	template <typename U> using WithSample = Sequence_BetterBlueNoise2T<ENGINE, U>;
+
+#if APPLETON_BITS_FROM_ENGINE()
+	typedef AppletonEngineBits<ENGINE> Bits;
+#else
+	typedef AppletonTinyBits Bits;
+#endif
+
+	Sequence_BetterBlueNoise2T(size_t, uint64_t sequenceIndex)
+#if APPLETON_BITS_FROM_ENGINE()
+		: m_stream(Bits(SequenceEngine<ENGINE>(sequenceIndex)))
+#else
+		: m_stream(Bits(SequenceEngine<ENGINE>(sequenceIndex).NextU32()))
+#endif
+	{
+	}
+
+	void Generate(T* out, size_t count)
+	{
+		m_stream.NextN(out, count);
+		m_generated += count;
+	}
+
+private:
+	BlueNoiseStreamAppletonT<T, Bits> m_stream;
+};
+
+// A forward Fisher-Yates shuffle, done a batch at a time, as they are asked for. See Shuffle.h.
+// Shuffling the whole thing this way gives the same result as shuffling it all up front.
+// Past numValues it starts over, with the same order.
+// The shuffle gets a different seed than the white noise, so they are independent.
+template <typename T>
+class LazyShuffle
+{
+public:
+	LazyShuffle(T* values, size_t numValues, uint64_t shuffleSeed)
+		: m_values(values)
+		, m_numValues(numValues)
+		, m_engine(~g_randomSeed, shuffleSeed)
+	{
+	}
+
+	T Next()
+	{
+		if (m_index == m_shuffled && m_shuffled < m_numValues)
+			m_shuffled += ShuffleBatch(m_values, m_numValues, m_shuffled, m_engine);
+		return m_values[m_index++ % m_numValues];
+	}
+
+private:
+	T* m_values;
+	size_t m_numValues;
+	size_t m_index = 0;
+	size_t m_shuffled = 0;
+	WhiteNoiseEngine m_engine;
+};
+
+// The whole base sequence has to exist before it can be shuffled, so it is generated up front into a per thread buffer.
+// Only one shuffled sequence can be alive per thread at a time. 0 samples is treated as 1, so there is something to shuffle.
+template <typename BASE>
+class Sequence_Shuffled : public SequenceBase
+{
+public:
+	typedef typename BASE::SampleType SampleType;
+	template <typename U> using WithSample = Sequence_Shuffled<typename BASE::template WithSample<U>>;
 
-	RedNoiseStreamPolynomial redNoiseRNG(rng);
+	Sequence_Shuffled(size_t numSamples, uint64_t sequenceIndex)
+		: m_shuffle(MakeBase(std::max<size_t>(numSamples, 1), sequenceIndex), std::max<size_t>(numSamples, 1), sequenceIndex)
+	{
+		m_generated = std::max<size_t>(numSamples, 1);
+	}
+
+	void Generate(SampleType* out, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			out[i] = m_shuffle.Next();
+	}
+
+private:
+	static SampleType* MakeBase(size_t numSamples, uint64_t sequenceIndex)
+	{
+		SampleType* values = ThreadScratchBuffer<ScratchBuffer::Shuffle, SampleType>(numSamples);
+		BASE(numSamples, sequenceIndex).Generate(values, numSamples);
+		return values;
+	}
+
+	LazyShuffle<SampleType> m_shuffle;
+};
+
+template <typename ENGINE, typename T = float> using Sequence_StratifiedPermutedT = Sequence_PipelineT<T, Stage_WhiteNoise<ENGINE>, Stage_PermutedStrata, Stage_Stratify>;
+template <typename ENGINE, typename T = float> using Sequence_RegularOffsetPermutedT = Sequence_PipelineT<T, Stage_RegularOffset<ENGINE>, Stage_PermutedStrata, Stage_Stratify>;
+
+#if SHUFFLE_BY_PERMUTATION()
+template <typename ENGINE, typename T = float> using Sequence_StratifiedShuffledT = Sequence_StratifiedPermutedT<ENGINE, T>;
+template <typename ENGINE, typename T = float> using Sequence_RegularOffsetShuffledT = Sequence_RegularOffsetPermutedT<ENGINE, T>;
+#else
+template <typename ENGINE, typename T = float> using Sequence_StratifiedShuffledT = Sequence_Shuffled<Sequence_StratifiedT<ENGINE, T>>;
+template <typename ENGINE, typename T = float> using Sequence_RegularOffsetShuffledT = Sequence_Shuffled<Sequence_RegularOffsetT<ENGINE, T>>;
+#endif
+
+typedef Sequence_WhiteNoiseT<WhiteNoiseEngine> Sequence_WhiteNoise;
+typedef Sequence_StratifiedT<WhiteNoiseEngine> Sequence_Stratified;
+typedef Sequence_RegularOffsetT<WhiteNoiseEngine> Sequence_RegularOffset;
+typedef Sequence_GoldenRatioT<WhiteNoiseEngine> Sequence_GoldenRatio;
+typedef Sequence_Sqrt2T<WhiteNoiseEngine> Sequence_Sqrt2;
+typedef Sequence_PlasticT<WhiteNoiseEngine> Sequence_Plastic;
+typedef Sequence_VanDerCorputT<WhiteNoiseEngine> Sequence_VanDerCorput;
+typedef Sequence_SobolT<WhiteNoiseEngine> Sequence_Sobol;
+typedef Sequence_Halton3T<WhiteNoiseEngine> Sequence_Halton3;
+typedef Sequence_Halton5T<WhiteNoiseEngine> Sequence_Halton5;
+typedef Sequence_BlueNoiseT<WhiteNoiseEngine> Sequence_BlueNoise;
+typedef Sequence_RedNoiseT<WhiteNoiseEngine> Sequence_RedNoise;
+typedef Sequence_BetterBlueNoiseT<WhiteNoiseEngine> Sequence_BetterBlueNoise;
+typedef Sequence_BetterBlueNoise2T<WhiteNoiseEngine> Sequence_BetterBlueNoise2;
+typedef Sequence_BetterRedNoiseT<WhiteNoiseEngine> Sequence_BetterRedNoise;
+typedef Sequence_BlueNoise5TapT<WhiteNoiseEngine> Sequence_BlueNoise5Tap;
+typedef Sequence_RedNoiseIIRT<WhiteNoiseEngine> Sequence_RedNoiseIIR;
+typedef Sequence_StratifiedShuffledT<WhiteNoiseEngine> Sequence_StratifiedShuffled;
+typedef Sequence_RegularOffsetShuffledT<WhiteNoiseEngine> Sequence_RegularOffsetShuffled;
+
+// Pulls samples from a sequence one at a time, generating them a block at a time, so that
+// the tests only pay for (about) as many samples as they use.
+// Blocks start small and double in size, so short uses don't over generate, and long uses still get big blocks.
+template <typename SEQUENCE>
+class LazySequence
+{
+public:
+	LazySequence(size_t numSamples, uint64_t sequenceIndex)
+		: m_sequence(numSamples, sequenceIndex)
+	{
+	}
+
+	typename SEQUENCE::SampleType Next()
+	{
+		if (m_blockIndex == m_blockSize)
+		{
+			m_blockSize = std::min(m_blockSize * 2, c_maxBlockSize);
+			m_sequence.Generate(m_block, m_blockSize);
+			m_blockIndex = 0;
+		}
+		return m_block[m_blockIndex++];
+	}
+
+	size_t Generated() const
+	{
+		return m_sequence.m_generated;
+	}
+
+private:
+	static const size_t c_minBlockSize = 4;
+	static const size_t c_maxBlockSize = 64;
+
+	SEQUENCE m_sequence;
+	typename SEQUENCE::SampleType m_block[c_maxBlockSize];
+	size_t m_blockSize = c_minBlockSize / 2;
+	size_t m_blockIndex = c_minBlockSize / 2;
+};
+
+// Float samples have 24 bits, so each of N buckets gets 2^24/N possible floats, give or take one.
+// Up to c_maxFloatBuckets that is off by less than half a percent. Past that the buckets get uneven, and
+// past 2^24 some can't be reached at all, so more buckets than this use double samples and 64 bit buckets.
+static const size_t c_maxFloatBuckets = 1 << 16;
+
+template <bool WIDE>
+struct BucketTypes
+{
+	typedef float Sample;
+	typedef uint32_t Bucket;
+};
+
+template <>
+struct BucketTypes<true>
+{
+	typedef double Sample;
+	typedef uint64_t Bucket;
+};
+
+template <size_t NUM_BUCKETS>
+using BucketTypesFor = BucketTypes<(NUM_BUCKETS > c_maxFloatBuckets)>;
 
-	std::vector<float> ret(numSamples);
-	for (float& f : ret)
-		f = redNoiseRNG.Next();
+inline void SamplesToBuckets(const float* in, uint32_t* out, size_t count, uint32_t numBuckets)
+{
+	Float01ToBuckets(in, out, count, numBuckets);
+}
 
-	return ret;
+inline void SamplesToBuckets(const double* in, uint64_t* out, size_t count, uint64_t numBuckets)
+{
+	Double01ToBuckets(in, out, count, numBuckets);
 }
 
-std::vector<float> ShuffleSequence(std::vector<float>& sequence, uint64_t shuffleSeed)
+// Generates the next count samples of a sequence, mapped to buckets in [0, numBuckets).
+// Sequences that only make floats or doubles get an exact mapping of the sample.
+// BUCKET is uint32_t for float sequences, and uint64_t for double sequences.
+template <typename SEQUENCE, typename BUCKET>
+void GenerateBuckets(SEQUENCE& sequence, BUCKET* out, size_t count, BUCKET numBuckets)
 {
-	std::mt19937 rng((unsigned int)shuffleSeed ^ (unsigned int)g_randomSeed);
-	std::shuffle(sequence.begin(), sequence.end(), rng);
-	return sequence;
+	static const size_t c_chunkSize = 256;
+	typename SEQUENCE::SampleType samples[c_chunkSize];
+	for (size_t chunkStart = 0; chunkStart < count; chunkStart += c_chunkSize)
+	{
+		size_t chunkCount = std::min(c_chunkSize, count - chunkStart);
+		sequence.Generate(samples, chunkCount);
+		SamplesToBuckets(samples, &out[chunkStart], chunkCount, numBuckets);
+	}
 }
 
-std::vector<float> Generate_StratifiedShuffled(size_t numSamples, uint64_t sequenceIndex)
+// White noise maps the raw 32 or 64 bit rng output with a multiply-shift instead
+template <typename ENGINE, typename T>
+void GenerateBuckets(Sequence_WhiteNoiseT<ENGINE, T>& sequence, uint32_t* out, size_t count, uint32_t numBuckets)
 {
-	std::vector<float> sequence = Generate_Stratified(numSamples, sequenceIndex);
-	return ShuffleSequence(sequence, sequenceIndex);
+	sequence.GenerateU32(out, count);
+	U32ToBuckets(out, out, count, numBuckets);
 }
 
-std::vector<float> Generate_RegularOffsetShuffled(size_t numSamples, uint64_t sequenceIndex)
+template <typename ENGINE, typename T>
+void GenerateBuckets(Sequence_WhiteNoiseT<ENGINE, T>& sequence, uint64_t* out, size_t count, uint64_t numBuckets)
 {
-	std::vector<float> sequence = Generate_RegularOffset(numSamples, sequenceIndex);
-	return ShuffleSequence(sequence, sequenceIndex);
+	sequence.GenerateU64(out, count);
+	U64ToBuckets(out, out, count, numBuckets);
 }
 
 // ================== TESTS ==================
 
-template <typename LAMBDA>
-void LotteryTest(const LAMBDA& RNG, uint64_t sequenceIndex, const char* label)
+// How many samples the sequences generated, versus how many the tests actually used
+struct SampleUsage
+{
+	float generatedAvg = 0.0f;
+	float consumedAvg = 0.0f;
+
+	void Add(size_t generated, size_t consumed, int testIndexInner)
+	{
+		Add(float(generated), float(consumed), testIndexInner);
+	}
+
+	// For when generated is only known on average, over a block of tests
+	void Add(float generated, float consumed, int testIndexInner)
+	{
+		generatedAvg = Lerp(generatedAvg, generated, 1.0f / float(testIndexInner + 1));
+		consumedAvg = Lerp(consumedAvg, consumed, 1.0f / float(testIndexInner + 1));
+	}
+};
+
+void ReportSampleUsage(const std::vector<SampleUsage>& usage)
+{
+	SampleUsage total;
+	for (size_t i = 0; i < usage.size(); ++i)
+	{
+		total.generatedAvg = Lerp(total.generatedAvg, usage[i].generatedAvg, 1.0f / float(i + 1));
+		total.consumedAvg = Lerp(total.consumedAvg, usage[i].consumedAvg, 1.0f / float(i + 1));
+	}
+	printf("    %0.1f samples generated, %0.1f samples consumed per test\n", total.generatedAvg, total.consumedAvg);
+}
+
+// How good an estimator is for the time it takes: the variance its result would have after one CPU second.
+// outerVariance is the variance of the per outer test averages. The CPU time is the time taken times the number of threads.
+void ReportEstimatorEfficiency(float outerVariance, size_t outerCount, double seconds)
+{
+	double cpuSeconds = seconds * double(omp_get_max_threads());
+	double resultVariance = double(outerVariance) / double(outerCount);
+	printf("    %0.2f CPU seconds, %e variance, %e variance after one CPU second\n", cpuSeconds, resultVariance, resultVariance * cpuSeconds);
+}
+
+template <typename SEQUENCE>
+void LotteryTest(uint64_t sequenceIndex, const char* label)
 {
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	// Float samples and 32 bit tickets when they are exact, double samples and 64 bit tickets when not
+	typedef BucketTypesFor<c_lotteryWinFrequency> LotteryTypes;
+	typedef typename SEQUENCE::template WithSample<typename LotteryTypes::Sample> LotterySequence;
+	typedef typename LotteryTypes::Bucket Bucket;
+
 	// we need a seed per test to generate the winning number, and another seed per test to generate the random numbers
 	uint64_t sequenceIndexBase = sequenceIndex * c_lotteryTestCountOuter * c_lotteryTestCountInner * 2;
 
 	// gather up the wins and losses
 	std::vector<float> wins(c_lotteryTestCountOuter, 0.0f);
+	std::vector<SampleUsage> usage(c_lotteryTestCountOuter);
 	std::atomic<int> testsFinished(0);
 	int lastPercent = -1;
 	#pragma omp parallel for
@@ -221,25 +907,36 @@ void LotteryTest(const LAMBDA& RNG, uint64_t sequenceIndex, const char* label)
 				}
 			}
 
-			int testIndex = testIndexOuter * c_lotteryTestCountInner + testIndexInner;
+			uint64_t testIndex = uint64_t(testIndexOuter) * c_lotteryTestCountInner + testIndexInner;
 
 			// Generate a winning number
-			size_t winningNumber = MapFloat<size_t>(Generate_WhiteNoise(1, sequenceIndexBase + testIndex * 2)[0], 0, c_lotteryWinFrequency - 1);
-
-			// Report whether the player won
-			std::vector<float> rng = RNG(c_lotteryWinFrequency, sequenceIndexBase + testIndex * 2 + 1);
+			Bucket winningNumber;
+			Sequence_WhiteNoiseT<WhiteNoiseEngine, typename LotteryTypes::Sample> winningNumberRNG(1, sequenceIndexBase + testIndex * 2);
+			GenerateBuckets(winningNumberRNG, &winningNumber, 1, (Bucket)c_lotteryWinFrequency);
+
+			// Report whether the player won.
+			// Tickets are generated as buckets a block at a time, with blocks doubling in size, and each block is
+			// searched for the winning number with SIMD. We stop generating at the first block with a win.
+			LotterySequence rng(c_lotteryWinFrequency, sequenceIndexBase + testIndex * 2 + 1);
+			Bucket tickets[c_lotteryMaxBlockSize];
 			float win = 0.0f;
-			for (const float& vf : rng)
+			size_t consumed = c_lotteryWinFrequency;
+			size_t blockSize = c_lotteryMinBlockSize;
+			for (size_t blockStart = 0; blockStart < c_lotteryWinFrequency; blockStart += blockSize, blockSize = std::min(blockSize * 2, c_lotteryMaxBlockSize))
 			{
-				size_t v = MapFloat<size_t>(vf, 0, c_lotteryWinFrequency - 1);
-				if (v == winningNumber)
+				size_t count = std::min(blockSize, c_lotteryWinFrequency - blockStart);
+				GenerateBuckets(rng, tickets, count, (Bucket)c_lotteryWinFrequency);
+				size_t found = FindBucket(tickets, count, winningNumber);
+				if (found < count)
 				{
 					win = 1.0f;
+					consumed = blockStart + found + 1;
 					break;
 				}
 			}
 
 			wins[testIndexOuter] = Lerp(wins[testIndexOuter], win, 1.0f / float(testIndexInner + 1));
+			usage[testIndexOuter].Add(rng.m_generated, consumed, testIndexInner);
 			testsFinished.fetch_add(1);
 		}
 	}
@@ -256,19 +953,195 @@ void LotteryTest(const LAMBDA& RNG, uint64_t sequenceIndex, const char* label)
 	float variance = losePercentSquared - losePercent * losePercent;
 	float stdDev = std::sqrt(variance);
 
+	std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+
 	printf("\r  %s: %f%% lose chance (%f%% std. dev.)\n", label, 100.0f * losePercent, 100.0f * stdDev);
+	ReportSampleUsage(usage);
+	ReportEstimatorEfficiency(variance, c_lotteryTestCountOuter, seconds.count());
 }
 
-template <typename LAMBDA>
-void SumTest(const LAMBDA& RNG, uint64_t sequenceIndex, const char* label)
+// Instead of a winning number per trial, all of a sequence's tickets are put in a bitmap of the possible numbers, and the
+// ones not covered are counted. The fraction not covered is the chance of losing over every winning number, exactly, for
+// that sequence. So the expected value is the same as LotteryTest's, but each trial is a lose chance instead of a win or
+// a loss, which has much less variance. Each trial uses all of the tickets though, where LotteryTest stops at the win.
+// The ticket sequences are the same as LotteryTest's.
+template <typename SEQUENCE>
+void LotteryCoverageTest(uint64_t sequenceIndex, const char* label)
 {
-	// we need a seed per test
-	uint64_t sequenceIndexBase = sequenceIndex * c_sumTestCountOuter * c_sumTestCountInner;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	typedef BucketTypesFor<c_lotteryWinFrequency> LotteryTypes;
+	typedef typename SEQUENCE::template WithSample<typename LotteryTypes::Sample> LotterySequence;
+	typedef typename LotteryTypes::Bucket Bucket;
+
+	uint64_t sequenceIndexBase = sequenceIndex * c_lotteryTestCountOuter * c_lotteryTestCountInner * 2;
+
+	std::vector<float> loses(c_lotteryCoverageTestCountOuter, 0.0f);
+	std::vector<SampleUsage> usage(c_lotteryCoverageTestCountOuter);
+	std::atomic<int> testsFinished(0);
+	int lastPercent = -1;
+	#pragma omp parallel for
+	for (int testIndexOuter = 0; testIndexOuter < c_lotteryCoverageTestCountOuter; ++testIndexOuter)
+	{
+		BucketCoverage coverage(c_lotteryWinFrequency);
+		for (int testIndexInner = 0; testIndexInner < c_lotteryCoverageTestCountInner; ++testIndexInner)
+		{
+			if (omp_get_thread_num() == 0)
+			{
+				int percent = int(100.0f * float(testsFinished.load()) / float(c_lotteryCoverageTestCountOuter * c_lotteryCoverageTestCountInner));
+				if (percent != lastPercent)
+				{
+					lastPercent = percent;
+					printf("\r  %s: %i%%", label, percent);
+				}
+			}
+
+			uint64_t testIndex = uint64_t(testIndexOuter) * c_lotteryTestCountInner + testIndexInner;
+
+			LotterySequence rng(c_lotteryWinFrequency, sequenceIndexBase + testIndex * 2 + 1);
+			Bucket tickets[c_lotteryMaxBlockSize];
+			coverage.Clear();
+			for (size_t blockStart = 0; blockStart < c_lotteryWinFrequency; blockStart += c_lotteryMaxBlockSize)
+			{
+				size_t count = std::min(c_lotteryMaxBlockSize, c_lotteryWinFrequency - blockStart);
+				GenerateBuckets(rng, tickets, count, (Bucket)c_lotteryWinFrequency);
+				coverage.Add(tickets, count);
+			}
+			float lose = float(c_lotteryWinFrequency - coverage.Covered()) / float(c_lotteryWinFrequency);
+
+			loses[testIndexOuter] = Lerp(loses[testIndexOuter], lose, 1.0f / float(testIndexInner + 1));
+			usage[testIndexOuter].Add(rng.m_generated, c_lotteryWinFrequency, testIndexInner);
+			testsFinished.fetch_add(1);
+		}
+	}
+
+	float losePercent = 0.0f;
+	float losePercentSquared = 0.0f;
+	for (size_t testIndexOuter = 0; testIndexOuter < c_lotteryCoverageTestCountOuter; ++testIndexOuter)
+	{
+		losePercent = Lerp(losePercent, loses[testIndexOuter], 1.0f / float(testIndexOuter + 1));
+		losePercentSquared = Lerp(losePercentSquared, loses[testIndexOuter] * loses[testIndexOuter], 1.0f / float(testIndexOuter + 1));
+	}
+
+	float variance = std::max(losePercentSquared - losePercent * losePercent, 0.0f);
+	float stdDev = std::sqrt(variance);
+
+	std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+
+	printf("\r  %s: %f%% lose chance (%f%% std. dev.)\n", label, 100.0f * losePercent, 100.0f * stdDev);
+	ReportSampleUsage(usage);
+	ReportEstimatorEfficiency(variance, c_lotteryCoverageTestCountOuter, seconds.count());
+}
+
+// The lose chance for every number of tickets bought, from 1 to c_lotteryWinFrequency. Like LotteryCoverageTest, but the
+// coverage also records when each number was first hit, and the lose chance with k tickets is the fraction of numbers not
+// hit in the first k. The tickets are the first k of a sequence made for c_lotteryWinFrequency of them, which is also what
+// LotteryTest uses when it stops early. The ticket sequences are the same as LotteryTest's.
+struct LotteryCurve
+{
+	const char* label;
+	std::vector<float> loseChance;  // loseChance[k] is for k tickets
+};
+
+template <typename SEQUENCE>
+LotteryCurve LotteryCurveTest(uint64_t sequenceIndex, const char* label)
+{
+	typedef BucketTypesFor<c_lotteryWinFrequency> LotteryTypes;
+	typedef typename SEQUENCE::template WithSample<typename LotteryTypes::Sample> LotterySequence;
+	typedef typename LotteryTypes::Bucket Bucket;
+
+	uint64_t sequenceIndexBase = sequenceIndex * c_lotteryTestCountOuter * c_lotteryTestCountInner * 2;
+
+	std::atomic<int> testsFinished(0);
+	int lastPercent = -1;
+	std::vector<std::vector<uint64_t>> firstHits(c_lotteryCurveTestCountOuter, std::vector<uint64_t>(c_lotteryWinFrequency, 0));
+	#pragma omp parallel for
+	for (int testIndexOuter = 0; testIndexOuter < c_lotteryCurveTestCountOuter; ++testIndexOuter)
+	{
+		BucketCoverage coverage(c_lotteryWinFrequency);
+		for (int testIndexInner = 0; testIndexInner < c_lotteryCurveTestCountInner; ++testIndexInner)
+		{
+			if (omp_get_thread_num() == 0)
+			{
+				int percent = int(100.0f * float(testsFinished.load()) / float(c_lotteryCurveTestCountOuter * c_lotteryCurveTestCountInner));
+				if (percent != lastPercent)
+				{
+					lastPercent = percent;
+					printf("\r  %s: %i%%", label, percent);
+				}
+			}
+
+			uint64_t testIndex = uint64_t(testIndexOuter) * c_lotteryTestCountInner + testIndexInner;
+
+			LotterySequence rng(c_lotteryWinFrequency, sequenceIndexBase + testIndex * 2 + 1);
+			Bucket tickets[c_lotteryMaxBlockSize];
+			coverage.Clear();
+			for (size_t blockStart = 0; blockStart < c_lotteryWinFrequency; blockStart += c_lotteryMaxBlockSize)
+			{
+				size_t count = std::min(c_lotteryMaxBlockSize, c_lotteryWinFrequency - blockStart);
+				GenerateBuckets(rng, tickets, count, (Bucket)c_lotteryWinFrequency);
+				coverage.AddFirstHits(tickets, count, blockStart, firstHits[testIndexOuter].data());
+			}
+			testsFinished.fetch_add(1);
+		}
+	}
+
+	LotteryCurve curve;
+	curve.label = label;
+	curve.loseChance.resize(c_lotteryWinFrequency + 1, 1.0f);
+	double possibleHits = double(c_lotteryCurveTestCountOuter * c_lotteryCurveTestCountInner) * double(c_lotteryWinFrequency);
+	uint64_t hits = 0;
+	for (size_t ticket = 0; ticket < c_lotteryWinFrequency; ++ticket)
+	{
+		for (size_t testIndexOuter = 0; testIndexOuter < c_lotteryCurveTestCountOuter; ++testIndexOuter)
+			hits += firstHits[testIndexOuter][ticket];
+		curve.loseChance[ticket + 1] = float(1.0 - double(hits) / possibleHits);
+	}
+
+	printf("\r  %s: %f%% lose chance with %i tickets, %f%% with %i\n", label, 100.0f * curve.loseChance[c_lotteryWinFrequency / 2], (int)(c_lotteryWinFrequency / 2),
+		100.0f * curve.loseChance[c_lotteryWinFrequency], (int)c_lotteryWinFrequency);
+	return curve;
+}
+
+// The lottery test, and then the coverage estimator on the same sequence if LOTTERY_COVERAGE_TEST()
+template <typename SEQUENCE>
+void LotteryTests(uint64_t sequenceIndex, const char* label)
+{
+	LotteryTest<SEQUENCE>(sequenceIndex, label);
+#if LOTTERY_COVERAGE_TEST()
+	std::string coverageLabel = std::string(label) + " (coverage)";
+	LotteryCoverageTest<SEQUENCE>(sequenceIndex, coverageLabel.c_str());
+#endif
+}
+
+void ReportSumTest(const std::vector<float>& sumCountAvg, const std::vector<float>& sumCountSquareAvg, const std::vector<SampleUsage>& usage, const char* label)
+{
+	// calculate and return the average count
+	float count = 0.0f;
+	float countSq = 0.0f;
+	for (size_t testIndex = 0; testIndex < c_sumTestCountOuter; ++testIndex)
+	{
+		count = Lerp(count, sumCountAvg[testIndex], 1.0f / float(testIndex + 1));
+		countSq = Lerp(countSq, sumCountSquareAvg[testIndex], 1.0f / float(testIndex + 1));
+	}
+
+	float variance = countSq - count * count;
+
+	printf("\r  %s: %f numbers to get >= 1.0  (%f std. dev.)\n", label, count, std::sqrt(variance));
+	ReportSampleUsage(usage);
+}
+
+template <typename SEQUENCE>
+void SumTest(uint64_t sequenceIndex, const char* label)
+{
+	// we need a seed per test
+	uint64_t sequenceIndexBase = sequenceIndex * c_sumTestCountOuter * c_sumTestCountInner;
 
 	std::atomic<int> testsFinished(0);
 	int lastPercent = -1;
 	std::vector<float> sumCountAvg(c_sumTestCountOuter, 0.0f);
 	std::vector<float> sumCountSquareAvg(c_sumTestCountOuter, 0.0f);
+	std::vector<SampleUsage> usage(c_sumTestCountOuter);
 	#pragma omp parallel for
 	for (int testIndexOuter = 0; testIndexOuter < c_sumTestCountOuter; ++testIndexOuter)
 	{
@@ -284,43 +1157,200 @@ void SumTest(const LAMBDA& RNG, uint64_t sequenceIndex, const char* label)
 				}
 			}
 
-			int testIndex = testIndexOuter * c_sumTestCountOuter + testIndexInner;
+			uint64_t testIndex = uint64_t(testIndexOuter) * c_sumTestCountOuter + testIndexInner;
 
-			std::vector<float> rng = RNG(25, sequenceIndexBase + testIndex);
-			float value = 0.0f;
-			for (size_t index = 0; index < rng.size(); ++index)
+			// If the sequence runs out before getting to 1, it's made again, twice as long, up to c_sumTestMaxDoublings times
+			static const size_t c_numSamples = 25;
+			size_t generated = 0;
+			bool reached = false;
+			for (size_t numSamples = c_numSamples; !reached && numSamples <= (c_numSamples << c_sumTestMaxDoublings); numSamples *= 2)
 			{
-				value += rng[index];
+				LazySequence<SEQUENCE> rng(numSamples, sequenceIndexBase + testIndex);
+				float value = 0.0f;
+				size_t consumed = 0;
+				while (consumed < numSamples && value < 1.0f)
+				{
+					value += rng.Next();
+					consumed++;
+				}
+				generated += rng.Generated();
 				if (value >= 1.0f)
 				{
-					float count = float(index + 1);
+					float count = float(consumed);
 					sumCountAvg[testIndexOuter] = Lerp(sumCountAvg[testIndexOuter], count, 1.0f / float(testIndexInner + 1));
 					sumCountSquareAvg[testIndexOuter] = Lerp(sumCountSquareAvg[testIndexOuter], count * count, 1.0f / float(testIndexInner + 1));
-					break;
+					usage[testIndexOuter].Add(generated, consumed, testIndexInner);
+					reached = true;
 				}
 			}
-			if (value < 1.0f)
+			if (!reached)
 				printf("[ERROR] Ran out of random numbers.\n");
 			testsFinished.fetch_add(1);
 		}
 	}
 
-	// calculate and return the average count
-	float count = 0.0f;
-	float countSq = 0.0f;
-	for (size_t testIndex = 0; testIndex < c_sumTestCountOuter; ++testIndex)
+	ReportSumTest(sumCountAvg, sumCountSquareAvg, usage, label);
+}
+
+// SumTest<Sequence_WhiteNoise>, with the trials done SumTrials lanes at a time (see SumTrials.h) instead of one at a time.
+// The lanes are seeded like Sequence_WhiteNoise's engine, so the counts are the same as SumTest's.
+// The lanes are PCG32, so for other white noise engines this is just SumTest.
+void SumTestLanes(uint64_t sequenceIndex, const char* label)
+{
+	if (!std::is_same<WhiteNoiseEngine, PCG32Engine>::value)
 	{
-		count = Lerp(count, sumCountAvg[testIndex], 1.0f / float(testIndex + 1));
-		countSq = Lerp(countSq, sumCountSquareAvg[testIndex], 1.0f / float(testIndex + 1));
+		SumTest<Sequence_WhiteNoise>(sequenceIndex, label);
+		return;
 	}
 
-	float variance = countSq - count * count;
+	static const size_t c_blockSize = 256;
 
-	printf("\r  %s: %f numbers to get >= 1.0  (%f std. dev.)\n", label, count, std::sqrt(variance));
+	// we need a seed per test
+	uint64_t sequenceIndexBase = sequenceIndex * c_sumTestCountOuter * c_sumTestCountInner;
+
+	std::atomic<int> testsFinished(0);
+	int lastPercent = -1;
+	std::vector<float> sumCountAvg(c_sumTestCountOuter, 0.0f);
+	std::vector<float> sumCountSquareAvg(c_sumTestCountOuter, 0.0f);
+	std::vector<SampleUsage> usage(c_sumTestCountOuter);
+	#pragma omp parallel for
+	for (int testIndexOuter = 0; testIndexOuter < int(c_sumTestCountOuter); ++testIndexOuter)
+	{
+		pcg32_random_t rngs[c_blockSize];
+		uint32_t counts[c_blockSize];
+		for (size_t blockStart = 0; blockStart < c_sumTestCountInner; blockStart += c_blockSize)
+		{
+			if (omp_get_thread_num() == 0)
+			{
+				int percent = int(100.0f * float(testsFinished.load()) / float(c_sumTestCountOuter * c_sumTestCountInner));
+				if (percent != lastPercent)
+				{
+					lastPercent = percent;
+					printf("\r  %s: %i%%", label, percent);
+				}
+			}
+
+			size_t blockCount = std::min(c_blockSize, c_sumTestCountInner - blockStart);
+			uint64_t testIndex = uint64_t(testIndexOuter) * c_sumTestCountOuter + blockStart;
+			SeedSequenceRNGs(rngs, sequenceIndexBase + testIndex, blockCount);
+
+			float generated = float(SumTrials(rngs, counts, blockCount)) / float(blockCount);
+
+			for (size_t i = 0; i < blockCount; ++i)
+			{
+				size_t testIndexInner = blockStart + i;
+				float count = float(counts[i]);
+				sumCountAvg[testIndexOuter] = Lerp(sumCountAvg[testIndexOuter], count, 1.0f / float(testIndexInner + 1));
+				sumCountSquareAvg[testIndexOuter] = Lerp(sumCountSquareAvg[testIndexOuter], count * count, 1.0f / float(testIndexInner + 1));
+				usage[testIndexOuter].Add(generated, count, int(testIndexInner));
+			}
+			testsFinished.fetch_add(int(blockCount));
+		}
+	}
+
+	ReportSumTest(sumCountAvg, sumCountSquareAvg, usage, label);
 }
 
-template <typename LAMBDA>
-void CandidatesTest(const LAMBDA& RNG, uint64_t sequenceIndex, const char* label)
+// The average count of numbers summed to get >= t, for every threshold t up to c_sumCurveMaxThreshold. For white noise this
+// is the renewal function, which is e at t = 1 and approaches 2t + 2/3.
+// One prefix sum pass per sequence gives every threshold: the count for t is one more than the number of sums below t.
+// So each sum adds one to the count of every threshold over it, and it goes in the bin of the first of those.
+// The counts are then the running total of the bins.
+// The sums are fixed point (see PrefixSum.h), not float, so they can round differently than SumTest's.
+// The sequences are the same as SumTest's, but are made for 4 * c_sumCurveMaxThreshold samples, and made again twice as long
+// if they run out before getting to c_sumCurveMaxThreshold.
+struct SumCurve
+{
+	const char* label;
+	std::vector<float> count;  // count[j] is for the threshold j / 2^c_sumCurveStepBits
+};
+
+template <typename SEQUENCE>
+SumCurve SumCurveTest(uint64_t sequenceIndex, const char* label)
+{
+	static const size_t c_thresholdCount = c_sumCurveMaxThreshold << c_sumCurveStepBits;
+	static const uint64_t c_maxSum = uint64_t(c_sumCurveMaxThreshold) << c_prefixSumFractionBits;
+	static const int c_binShift = c_prefixSumFractionBits - c_sumCurveStepBits;
+	static const size_t c_blockSize = 16;
+
+	// we need a seed per test
+	uint64_t sequenceIndexBase = sequenceIndex * c_sumTestCountOuter * c_sumTestCountInner;
+
+	std::atomic<int> testsFinished(0);
+	int lastPercent = -1;
+	std::vector<std::vector<uint64_t>> bins(c_sumCurveTestCountOuter, std::vector<uint64_t>(c_thresholdCount + 1, 0));
+	std::vector<SampleUsage> usage(c_sumCurveTestCountOuter);
+	#pragma omp parallel for
+	for (int testIndexOuter = 0; testIndexOuter < c_sumCurveTestCountOuter; ++testIndexOuter)
+	{
+		std::vector<uint32_t> sequenceBins;
+		for (int testIndexInner = 0; testIndexInner < c_sumCurveTestCountInner; ++testIndexInner)
+		{
+			if (omp_get_thread_num() == 0)
+			{
+				int percent = int(100.0f * float(testsFinished.load()) / float(c_sumCurveTestCountOuter * c_sumCurveTestCountInner));
+				if (percent != lastPercent)
+				{
+					lastPercent = percent;
+					printf("\r  %s: %i%%", label, percent);
+				}
+			}
+
+			uint64_t testIndex = uint64_t(testIndexOuter) * c_sumTestCountOuter + testIndexInner;
+
+			static const size_t c_numSamples = 4 * c_sumCurveMaxThreshold;
+			size_t generated = 0;
+			bool reached = false;
+			for (size_t numSamples = c_numSamples; !reached && numSamples <= (c_numSamples << c_sumTestMaxDoublings); numSamples *= 2)
+			{
+				SEQUENCE rng(numSamples, sequenceIndexBase + testIndex);
+				sequenceBins.clear();
+				uint64_t sum = 0;
+				for (size_t blockStart = 0; blockStart < numSamples && sum < c_maxSum; blockStart += c_blockSize)
+				{
+					float samples[c_blockSize];
+					uint64_t sums[c_blockSize];
+					size_t count = std::min(c_blockSize, numSamples - blockStart);
+					rng.Generate(samples, count);
+					sum = PrefixSums(samples, sums, count, sum);
+					for (size_t i = 0; i < count && sums[i] < c_maxSum; ++i)
+						sequenceBins.push_back(uint32_t(sums[i] >> c_binShift) + 1);
+				}
+				generated += rng.m_generated;
+				if (sum >= c_maxSum)
+				{
+					for (uint32_t bin : sequenceBins)
+						bins[testIndexOuter][bin]++;
+					usage[testIndexOuter].Add(generated, sequenceBins.size() + 1, testIndexInner);
+					reached = true;
+				}
+			}
+			if (!reached)
+				printf("[ERROR] Ran out of random numbers.\n");
+			testsFinished.fetch_add(1);
+		}
+	}
+
+	SumCurve curve;
+	curve.label = label;
+	curve.count.resize(c_thresholdCount + 1);
+	double sequenceCount = double(c_sumCurveTestCountOuter * c_sumCurveTestCountInner);
+	uint64_t sumsBelow = 0;
+	for (size_t threshold = 0; threshold <= c_thresholdCount; ++threshold)
+	{
+		for (size_t testIndexOuter = 0; testIndexOuter < c_sumCurveTestCountOuter; ++testIndexOuter)
+			sumsBelow += bins[testIndexOuter][threshold];
+		curve.count[threshold] = float(1.0 + double(sumsBelow) / sequenceCount);
+	}
+
+	printf("\r  %s: %f numbers to get >= 1.0, %f to get >= %i (2t + 2/3 = %f)\n", label, curve.count[size_t(1) << c_sumCurveStepBits],
+		curve.count[c_thresholdCount], (int)c_sumCurveMaxThreshold, 2.0f * float(c_sumCurveMaxThreshold) + 2.0f / 3.0f);
+	ReportSampleUsage(usage);
+	return curve;
+}
+
+template <typename SEQUENCE>
+void CandidatesTest(uint64_t sequenceIndex, const char* label)
 {
 	// we need a seed per test
 	uint64_t sequenceIndexBase = sequenceIndex * c_candidateTestCountOuter * c_candidateTestCountInner;
@@ -336,6 +1366,7 @@ void CandidatesTest(const LAMBDA& RNG, uint64_t sequenceIndex, const char* label
 	std::atomic<int> testsFinished(0);
 	int lastPercent = -1;
 	std::vector<TestResults> results(c_candidateTestCountOuter);
+	std::vector<SampleUsage> usage(c_candidateTestCountOuter);
 	#pragma omp parallel for
 	for (int testIndexOuter = 0; testIndexOuter < c_candidateTestCountOuter; ++testIndexOuter)
 	{
@@ -351,46 +1382,27 @@ void CandidatesTest(const LAMBDA& RNG, uint64_t sequenceIndex, const char* label
 				}
 			}
 
-			int testIndex = testIndexOuter * c_sumTestCountOuter + testIndexInner;
+			uint64_t testIndex = uint64_t(testIndexOuter) * c_sumTestCountOuter + testIndexInner;
 
-			std::vector<float> candidates = RNG(c_candidateCount, sequenceIndexBase + testIndex);
-
-			// Find the best candidate in the pre candidate group.
-			// THe pre candidate group is candidateCount / e in size
+			// The candidates are generated a chunk at a time, and each chunk is scanned as it comes, so they are never stored.
+			// See Candidates.h. The pre candidate group, before the cutoff, is candidateCount / e in size.
 			size_t preCandidates = size_t(float(c_candidateCount) / std::exp(1.0f));
-			float bestPreCandidate = 0.0f;
-			for (size_t i = 0; i < preCandidates; ++i)
-				bestPreCandidate = std::max(bestPreCandidate, candidates[i]);
-
-			// Find the first candidate in the second group that is > that candidate, and take that as the winner
-			size_t foundAt = 0;
-			float bestCandidate = 0.0f;
-			for (size_t i = preCandidates; i < c_candidateCount; ++i)
-			{
-				if (candidates[i] > bestPreCandidate)
-				{
-					bestCandidate = candidates[i];
-					foundAt = i;
-					break;
-				}
-			}
-			if (foundAt == 0)
+			CandidateScan scan(preCandidates);
+			SEQUENCE sequence(c_candidateCount, sequenceIndexBase + testIndex);
+			float candidates[c_candidateChunkSize];
+			for (size_t chunkStart = 0; chunkStart < c_candidateCount; chunkStart += c_candidateChunkSize)
 			{
-				foundAt = c_candidateCount - 1;
-				bestCandidate = bestPreCandidate;
-				//printf("[ERROR] Ran out of random numbers.\n");
+				size_t chunkCount = std::min(c_candidateChunkSize, c_candidateCount - chunkStart);
+				sequence.Generate(candidates, chunkCount);
+				scan.Scan(candidates, chunkCount);
 			}
+			usage[testIndexOuter].Add(sequence.m_generated, c_candidateCount, testIndexInner);
+
+			size_t foundAt = scan.ChosenIndex();
 			results[testIndexOuter].candidatesEvaluatedAvg = Lerp(results[testIndexOuter].candidatesEvaluatedAvg, float(foundAt), 1.0f / float(testIndexInner + 1));
 			results[testIndexOuter].candidatesEvaluatedSqAvg = Lerp(results[testIndexOuter].candidatesEvaluatedSqAvg, float(foundAt * foundAt), 1.0f / float(testIndexInner + 1));
 
-			// find out how many candidates are better than what we found.
-			size_t betterCount = 0;
-			for (size_t i = 0; i < c_candidateCount; ++i)
-			{
-				if (candidates[i] > bestCandidate)
-					betterCount++;
-			}
-
+			size_t betterCount = scan.BetterCount();
 			results[testIndexOuter].candidateRankAvg = Lerp(results[testIndexOuter].candidateRankAvg, float(betterCount), 1.0f / float(testIndexInner + 1));
 			results[testIndexOuter].candidateRankSqAvg = Lerp(results[testIndexOuter].candidateRankSqAvg, float(betterCount * betterCount), 1.0f / float(testIndexInner + 1));
 			testsFinished.fetch_add(1);
@@ -413,53 +1425,1511 @@ void CandidatesTest(const LAMBDA& RNG, uint64_t sequenceIndex, const char* label
 	float candidateRankStdDev = std::sqrt(candidateRankVariance);
 
 	printf("\r  %s: \n    %0.1f / %i candidates looked at (%f std. dev.)\n    %f candidates were better (%f std. dev.)\n", label, result.candidatesEvaluatedAvg, (int)c_candidateCount, candidatesEvaluatedStdDev, result.candidateRankAvg, candidateRankStdDev);
+	ReportSampleUsage(usage);
 }
 
-int main(int argc, char** argv)
+// For each cutoff from 1 to c_candidateCount, how often the best candidate was taken, and how many candidates were better
+// than the one taken, on average. Instead of running CandidatesTest once per cutoff, every cutoff is evaluated from each
+// set of candidates at once. See CandidateCutoffSweep in Candidates.h.
+struct CutoffCurves
 {
-#if !DETERMINISTIC()
-	std::random_device rd;
-	g_randomSeed = rd();
-#endif
+	const char* label;
+	std::vector<float> success;
+	std::vector<float> rank;
+};
 
-	printf("e = %f\n", std::exp(1.0f));
-	printf("1/e = %f\n\n", 1.0f / std::exp(1.0f));
+template <typename SEQUENCE>
+CutoffCurves CandidateCutoffSweepTest(uint64_t sequenceIndex, const char* label)
+{
+	// we need a seed per test
+	uint64_t sequenceIndexBase = sequenceIndex * c_cutoffSweepTestCountOuter * c_cutoffSweepTestCountInner;
 
-	// NOTE: more evenly spaced sampling means fewer duplicates, which is why they win more.
-	printf("Lottery Lose Chance:\n");
-	LotteryTest(Generate_WhiteNoise, 0, "White Noise");
-	LotteryTest(Generate_GoldenRatio, 1, "Golden Ratio");
-	LotteryTest(Generate_Stratified, 2, "Stratified");
-	LotteryTest(Generate_RegularOffset, 3, "Regular Offset");
-	LotteryTest(Generate_RedNoise, 4, "Red Noise");
-	LotteryTest(Generate_BlueNoise, 5, "Blue Noise");
-	LotteryTest(Generate_BetterRedNoise, 6, "Better Red Noise");
-	LotteryTest(Generate_BetterBlueNoise, 7, "Better Blue Noise");
-	LotteryTest(Generate_BetterBlueNoise2, 8, "Better Blue Noise 2");
+	std::atomic<int> testsFinished(0);
+	int lastPercent = -1;
+	std::vector<std::vector<uint64_t>> successes(c_cutoffSweepTestCountOuter, std::vector<uint64_t>(c_candidateCount + 1, 0));
+	std::vector<std::vector<uint64_t>> betterCounts(c_cutoffSweepTestCountOuter, std::vector<uint64_t>(c_candidateCount + 1, 0));
+	#pragma omp parallel for
+	for (int testIndexOuter = 0; testIndexOuter < c_cutoffSweepTestCountOuter; ++testIndexOuter)
+	{
+		CandidateCutoffSweep sweep;
+		for (int testIndexInner = 0; testIndexInner < c_cutoffSweepTestCountInner; ++testIndexInner)
+		{
+			if (omp_get_thread_num() == 0)
+			{
+				int percent = int(100.0f * float(testsFinished.load()) / float(c_cutoffSweepTestCountOuter * c_cutoffSweepTestCountInner));
+				if (percent != lastPercent)
+				{
+					lastPercent = percent;
+					printf("\r  %s: %i%%", label, percent);
+				}
+			}
 
-	// NOTE: shuffling stratified and regular offset cause they are only appropriate when we know the number of samples in advance. we don't for this test.
-	printf("\nSumming Random Values:\n");
-	SumTest(Generate_WhiteNoise, 0, "White Noise");
-	SumTest(Generate_GoldenRatio, 1, "Golden Ratio");
-	SumTest(Generate_StratifiedShuffled, 2, "Stratified Shuffled");
-	SumTest(Generate_RegularOffsetShuffled, 3, "Regular Offset Shuffled");
-	SumTest(Generate_RedNoise, 4, "Red Noise");
-	SumTest(Generate_BlueNoise, 5, "Blue Noise");
-	SumTest(Generate_BetterRedNoise, 6, "Better Red Noise");
-	SumTest(Generate_BetterBlueNoise, 7, "Better Blue Noise");
-	SumTest(Generate_BetterBlueNoise2, 8, "Better Blue Noise 2");
+			uint64_t testIndex = uint64_t(testIndexOuter) * c_cutoffSweepTestCountInner + testIndexInner;
+
+			// Every cutoff needs every candidate, so they are all generated up front
+			float* candidates = ThreadScratchBuffer<ScratchBuffer::Test>(c_candidateCount);
+			SEQUENCE(c_candidateCount, sequenceIndexBase + testIndex).Generate(candidates, c_candidateCount);
+			sweep.Add(candidates, c_candidateCount, successes[testIndexOuter].data(), betterCounts[testIndexOuter].data());
+			testsFinished.fetch_add(1);
+		}
+	}
+
+	CutoffCurves curves;
+	curves.label = label;
+	curves.success.resize(c_candidateCount + 1, 0.0f);
+	curves.rank.resize(c_candidateCount + 1, 0.0f);
+	double testCount = double(c_cutoffSweepTestCountOuter * c_cutoffSweepTestCountInner);
+	for (size_t cutoff = 1; cutoff <= c_candidateCount; ++cutoff)
+	{
+		uint64_t successCount = 0;
+		uint64_t betterCount = 0;
+		for (size_t testIndexOuter = 0; testIndexOuter < c_cutoffSweepTestCountOuter; ++testIndexOuter)
+		{
+			successCount += successes[testIndexOuter][cutoff];
+			betterCount += betterCounts[testIndexOuter][cutoff];
+		}
+		curves.success[cutoff] = float(double(successCount) / testCount);
+		curves.rank[cutoff] = float(double(betterCount) / testCount);
+	}
+
+	size_t bestSuccessCutoff = size_t(std::max_element(curves.success.begin() + 1, curves.success.end()) - curves.success.begin());
+	size_t bestRankCutoff = size_t(std::min_element(curves.rank.begin() + 1, curves.rank.end()) - curves.rank.begin());
+	size_t eCutoff = size_t(float(c_candidateCount) / std::exp(1.0f));
+	printf("\r  %s:\n    best chance at cutoff %i: %0.2f%% (%0.2f%% at %i, N/e)\n    fewest better at cutoff %i: %f (%f at %i, N/e)\n", label,
+		(int)bestSuccessCutoff, 100.0f * curves.success[bestSuccessCutoff], 100.0f * curves.success[eCutoff], (int)eCutoff,
+		(int)bestRankCutoff, curves.rank[bestRankCutoff], curves.rank[eCutoff], (int)eCutoff);
+	return curves;
+}
+
+// ================ BENCHMARKS ================
+
+static const size_t c_benchmarkSeedCount = 10000000;
+
+template <typename LAMBDA>
+double TimeSeconds(const LAMBDA& lambda)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	lambda();
+	std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now() - start;
+	return duration.count();
+}
+
+template <typename LAMBDA>
+void SeedingBenchmark(const LAMBDA& SeedRNG, const char* label)
+{
+	// Seed a sequence per trial, and take one number from it so the seeding can't be optimized away
+	uint32_t checksum = 0;
+	double seconds = TimeSeconds([&]()
+		{
+			for (size_t sequenceIndex = 0; sequenceIndex < c_benchmarkSeedCount; ++sequenceIndex)
+			{
+				pcg32_random_t rng;
+				SeedRNG(rng, sequenceIndex);
+				checksum ^= pcg32_random_r(&rng);
+			}
+		}
+	);
+
+	printf("  %s: %0.2f ns per trial setup (checksum %08x)\n", label, 1e9 * seconds / double(c_benchmarkSeedCount), checksum);
+}
+
+static const size_t c_benchmarkSampleCount = 100000000;
+
+template <typename ENGINE>
+void EngineThroughputBenchmark(const char* label)
+{
+	// Fill floats a block at a time, like the sequences do
+	static const size_t c_blockSize = 1024;
+	float block[c_blockSize];
+	float checksum = 0.0f;
+	ENGINE engine = SequenceEngine<ENGINE>(0);
+	double seconds = TimeSeconds([&]()
+		{
+			for (size_t sampleIndex = 0; sampleIndex < c_benchmarkSampleCount; sampleIndex += c_blockSize)
+			{
+				engine.Fill(block, c_blockSize);
+				checksum += block[0];
+			}
+		}
+	);
+
+	printf("  %s: %0.3f ns per sample (checksum %f)\n", label, 1e9 * seconds / double(c_benchmarkSampleCount), checksum);
+}
+
+template <typename ENGINE>
+void EngineExperimentBenchmark(const char* label)
+{
+	// Run all three tests on white noise from this engine. The results are the quality check.
+	printf("%s:\n", label);
+	double seconds = TimeSeconds([]()
+		{
+			LotteryTest<Sequence_WhiteNoiseT<ENGINE>>(0, "Lottery");
+			SumTest<Sequence_WhiteNoiseT<ENGINE>>(0, "Sum");
+			CandidatesTest<Sequence_WhiteNoiseT<ENGINE>>(0, "Candidates");
+		}
+	);
+	printf("  %0.2f seconds total\n\n", seconds);
+}
+
+static const size_t c_benchmarkShuffleElementCount = 20000000;
+
+template <typename LAMBDA>
+void ShuffleBenchmark(const LAMBDA& Shuffle, size_t count, const char* label)
+{
+	// Shuffle the same values over and over, with a new seed each time
+	std::vector<uint32_t> values(count);
+	for (size_t i = 0; i < count; ++i)
+		values[i] = (uint32_t)i;
+	size_t shuffleCount = c_benchmarkShuffleElementCount / count;
+	double seconds = TimeSeconds([&]()
+		{
+			for (size_t shuffleIndex = 0; shuffleIndex < shuffleCount; ++shuffleIndex)
+				Shuffle(values.data(), count, shuffleIndex);
+		}
+	);
+
+	printf("    %s: %0.1f ns per shuffle, %0.2f ns per element (checksum %u)\n", label, 1e9 * seconds / double(shuffleCount), 1e9 * seconds / double(shuffleCount * count), values[0] ^ values[count - 1]);
+}
+
+// Generating whole shuffled sequences, one after another
+template <typename SEQUENCE>
+void ShuffledSequenceBenchmark(size_t count, const char* label)
+{
+	std::vector<float> values(count);
+	size_t sequenceCount = c_benchmarkShuffleElementCount / count;
+	float checksum = 0.0f;
+	double seconds = TimeSeconds([&]()
+		{
+			for (size_t sequenceIndex = 0; sequenceIndex < sequenceCount; ++sequenceIndex)
+			{
+				SEQUENCE(count, sequenceIndex).Generate(values.data(), count);
+				checksum += values[count - 1];
+			}
+		}
+	);
+
+	printf("    %s: %0.1f ns per sequence, %0.2f ns per element (checksum %f)\n", label, 1e9 * seconds / double(sequenceCount), 1e9 * seconds / double(sequenceCount * count), checksum);
+}
+
+void ShuffleBenchmarks()
+{
+	for (size_t count : {25, 1000, 10000})
+	{
+		printf("  %i elements:\n", (int)count);
+
+		// What the shuffled sequences used to do: seed an mt19937 per shuffle
+		ShuffleBenchmark([](uint32_t* values, size_t count, uint64_t seed)
+			{
+				std::mt19937 rng((unsigned int)seed);
+				std::shuffle(values, values + count, rng);
+			}, count, "mt19937 + std::shuffle"
+		);
+
+		// Just the shuffle, with the mt19937 seeded once
+		std::mt19937 rng(0);
+		ShuffleBenchmark([&](uint32_t* values, size_t count, uint64_t)
+			{
+				std::shuffle(values, values + count, rng);
+			}, count, "std::shuffle, mt19937 seeded once"
+		);
+
+		ShuffleBenchmark([](uint32_t* values, size_t count, uint64_t seed)
+			{
+				PCG32Engine engine(g_randomSeed, seed);
+				BatchedShuffle(values, count, engine);
+			}, count, "PCG32 + batched dice"
+		);
+
+		ShuffleBenchmark([](uint32_t* values, size_t count, uint64_t seed)
+			{
+				WyRandEngine engine(g_randomSeed, seed);
+				BatchedShuffle(values, count, engine);
+			}, count, "wyrand + batched dice"
+		);
+
+		// The tests only use the path SHUFFLE_BY_PERMUTATION() picks, so both are timed here
+		ShuffledSequenceBenchmark<Sequence_Shuffled<Sequence_Stratified>>(count, "Stratified, generated then batched dice shuffled");
+		ShuffledSequenceBenchmark<Sequence_StratifiedPermutedT<WhiteNoiseEngine>>(count, "Stratified, Feistel permuted strata");
+	}
+}
+
+static const double c_pi = 3.14159265358979323846;
+static const size_t c_spectrumSize = 64;
+static const size_t c_spectrumBandCount = 4;
+static const size_t c_spectrumBlockCount = 16384;
+
+// Prints the average power spectrum of c_spectrumBlockCount blocks of c_spectrumSize samples, in bands from low to high frequency.
+// The samples are uniform [0,1], so the power is divided by their variance, 1/12, which makes white noise 1 in every band.
+// Blue noise should be low in the low bands and high in the high ones.
+void PrintSpectrumBands(const float* samples)
+{
+	double cosTable[c_spectrumSize];
+	double sinTable[c_spectrumSize];
+	for (size_t i = 0; i < c_spectrumSize; ++i)
+	{
+		cosTable[i] = std::cos(2.0 * c_pi * double(i) / double(c_spectrumSize));
+		sinTable[i] = std::sin(2.0 * c_pi * double(i) / double(c_spectrumSize));
+	}
+
+	static const size_t c_frequencyCount = c_spectrumSize / 2;
+	double bands[c_spectrumBandCount] = {};
+	for (size_t blockIndex = 0; blockIndex < c_spectrumBlockCount; ++blockIndex)
+	{
+		const float* block = &samples[blockIndex * c_spectrumSize];
+		for (size_t frequency = 1; frequency <= c_frequencyCount; ++frequency)
+		{
+			double real = 0.0;
+			double imaginary = 0.0;
+			for (size_t i = 0; i < c_spectrumSize; ++i)
+			{
+				double x = double(block[i]) - 0.5;
+				real += x * cosTable[(frequency * i) % c_spectrumSize];
+				imaginary -= x * sinTable[(frequency * i) % c_spectrumSize];
+			}
+			bands[(frequency - 1) * c_spectrumBandCount / c_frequencyCount] += (real * real + imaginary * imaginary) / double(c_spectrumSize);
+		}
+	}
+
+	printf("    spectrum, low to high (white noise = 1):");
+	for (size_t band = 0; band < c_spectrumBandCount; ++band)
+		printf(" %0.3f", bands[band] * 12.0 / double(c_spectrumBlockCount * c_frequencyCount / c_spectrumBandCount));
+	printf("\n");
+}
+
+template <typename BITS>
+void AppletonBenchmark(const BITS& bits, const char* label)
+{
+	// Time Next() and NextN() on copies of the same stream, then check the spectrum of what it makes
+	static const size_t c_blockSize = 4096;
+	float block[c_blockSize];
+	float checksum = 0.0f;
+
+	BlueNoiseStreamAppletonT<float, BITS> nextStream(bits);
+	double nextSeconds = TimeSeconds([&]()
+		{
+			for (size_t sampleIndex = 0; sampleIndex < c_benchmarkSampleCount; sampleIndex += c_blockSize)
+			{
+				for (size_t i = 0; i < c_blockSize; ++i)
+					block[i] = nextStream.Next();
+				checksum += block[0];
+			}
+		}
+	);
+
+	BlueNoiseStreamAppletonT<float, BITS> nextNStream(bits);
+	double nextNSeconds = TimeSeconds([&]()
+		{
+			for (size_t sampleIndex = 0; sampleIndex < c_benchmarkSampleCount; sampleIndex += c_blockSize)
+			{
+				nextNStream.NextN(block, c_blockSize);
+				checksum += block[0];
+			}
+		}
+	);
+
+	// NextN() again without the SIMD scan, to show what the scan itself is worth
+	SIMDLevel level = ActiveSIMDLevel();
+	ActiveSIMDLevel() = SIMDLevel::Scalar;
+	BlueNoiseStreamAppletonT<float, BITS> scalarStream(bits);
+	double scalarSeconds = TimeSeconds([&]()
+		{
+			for (size_t sampleIndex = 0; sampleIndex < c_benchmarkSampleCount; sampleIndex += c_blockSize)
+			{
+				scalarStream.NextN(block, c_blockSize);
+				checksum += block[0];
+			}
+		}
+	);
+	ActiveSIMDLevel() = level;
+
+	printf("  %s: Next() %0.3f ns per sample, NextN() %0.3f ns per sample, NextN() without the SIMD scan %0.3f ns per sample (checksum %f)\n", label,
+		1e9 * nextSeconds / double(c_benchmarkSampleCount), 1e9 * nextNSeconds / double(c_benchmarkSampleCount), 1e9 * scalarSeconds / double(c_benchmarkSampleCount), checksum);
+
+	std::vector<float> samples(c_spectrumSize * c_spectrumBlockCount);
+	BlueNoiseStreamAppletonT<float, BITS> spectrumStream(bits);
+	spectrumStream.NextN(samples.data(), samples.size());
+	PrintSpectrumBands(samples.data());
+}
+
+static const size_t c_cdfBenchmarkBlockSize = 4096;
+static const size_t c_cdfErrorPointCount = 1 << 24;
+
+// Times making c_benchmarkSampleCount uniform random values in [0,1] uniform, a block at a time.
+// It's only the speed that matters here, not that they are uniform already.
+template <typename LAMBDA>
+double CDFSeconds(const LAMBDA& MakeUniform, float& checksum)
+{
+	std::vector<float> in(c_cdfBenchmarkBlockSize);
+	std::vector<float> out(c_cdfBenchmarkBlockSize);
+	SequenceEngine<PCG32Engine>(0).Fill(in.data(), in.size());
+	return TimeSeconds([&]()
+		{
+			for (size_t sampleIndex = 0; sampleIndex < c_benchmarkSampleCount; sampleIndex += c_cdfBenchmarkBlockSize)
+			{
+				MakeUniform(in.data(), out.data(), c_cdfBenchmarkBlockSize);
+				checksum += out[sampleIndex % c_cdfBenchmarkBlockSize];
+			}
+		}
+	);
+}
+
+// The error of a table of FUNCTION against FUNCTION itself, and how fast the table is
+template <size_t SIZE, typename FUNCTION>
+void CDFTableBenchmark(const FUNCTION& function)
+{
+	// On the heap, since the big ones are too big for the stack
+	std::unique_ptr<CDFTable<SIZE>> table(new CDFTable<SIZE>(function));
+
+	double maxError = 0.0;
+	for (size_t i = 0; i <= c_cdfErrorPointCount; ++i)
+	{
+		float x = float(double(i) / double(c_cdfErrorPointCount));
+		maxError = std::max(maxError, std::abs(double(EvaluateCDFTable(*table, x)) - function(double(x))));
+	}
+
+	float checksum = 0.0f;
+	double scalarSeconds = CDFSeconds([&](const float* in, float* out, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+				out[i] = EvaluateCDFTable(*table, in[i]);
+		},
+		checksum
+	);
+	double simdSeconds = CDFSeconds([&](const float* in, float* out, size_t count)
+		{
+			EvaluateCDFTable(*table, in, out, count);
+		},
+		checksum
+	);
+
+	printf("    %i entries: max error %0.2e, scalar %0.3f ns per sample, SIMD %0.3f ns per sample (checksum %f)\n", (int)SIZE, maxError,
+		1e9 * scalarSeconds / double(c_benchmarkSampleCount), 1e9 * simdSeconds / double(c_benchmarkSampleCount), checksum);
+}
+
+template <typename FUNCTION>
+void CDFTableSizeBenchmarks(const FUNCTION& function)
+{
+	CDFTableBenchmark<256>(function);
+	CDFTableBenchmark<1024>(function);
+	CDFTableBenchmark<4096>(function);
+	CDFTableBenchmark<16384>(function);
+	CDFTableBenchmark<65536>(function);
+}
+
+// The polynomials the tables replace, for the blue and red noise streams
+struct NoisePolynomialCDF
+{
+	double operator()(double x) const { return EvaluateNoiseCDFPolynomial(BlueNoiseFilter::CDF(), x); }
+};
+
+void CDFBenchmarks()
+{
+	float checksum = 0.0f;
+	double seconds = CDFSeconds([](const float* in, float* out, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+				out[i] = TriangleToUniform(in[i]);
+		},
+		checksum
+	);
+	printf("  Triangle, exact: %0.3f ns per sample (checksum %f)\n", 1e9 * seconds / double(c_benchmarkSampleCount), checksum);
+	CDFTableSizeBenchmarks(TriangleCDF());
+
+	// The SIMD polynomials apply a scale and offset first, so they get ones that do nothing
+	NoiseCDF cdf = BlueNoiseFilter::CDF();
+	cdf.scale = 1.0f;
+	cdf.offset = 0.0f;
+	checksum = 0.0f;
+	double scalarSeconds = CDFSeconds([&](const float* in, float* out, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+				out[i] = EvaluateNoiseCDFPolynomial(cdf, in[i]);
+		},
+		checksum
+	);
+	double simdSeconds = CDFSeconds([&](const float* in, float* out, size_t count)
+		{
+			EvaluateNoiseCDF(in, out, count, cdf);
+		},
+		checksum
+	);
+	printf("  Noise polynomials: scalar %0.3f ns per sample, SIMD %0.3f ns per sample (checksum %f)\n",
+		1e9 * scalarSeconds / double(c_benchmarkSampleCount), 1e9 * simdSeconds / double(c_benchmarkSampleCount), checksum);
+	CDFTableSizeBenchmarks(NoisePolynomialCDF());
+}
+
+static const size_t c_benchmarkCandidateTrials = 1000000;
+static const size_t c_benchmarkCandidateSets = 1024;
+
+// What CandidatesTest used to do, for comparison: all of the candidates up front, then three passes over them
+void CandidatesThreePasses(const float* candidates, size_t cutoff, size_t& foundAt, size_t& betterCount)
+{
+	float bestPreCandidate = 0.0f;
+	for (size_t i = 0; i < cutoff; ++i)
+		bestPreCandidate = std::max(bestPreCandidate, candidates[i]);
+
+	foundAt = 0;
+	float bestCandidate = 0.0f;
+	for (size_t i = cutoff; i < c_candidateCount; ++i)
+	{
+		if (candidates[i] > bestPreCandidate)
+		{
+			bestCandidate = candidates[i];
+			foundAt = i;
+			break;
+		}
+	}
+	if (foundAt == 0)
+	{
+		foundAt = c_candidateCount - 1;
+		bestCandidate = bestPreCandidate;
+	}
+
+	betterCount = 0;
+	for (size_t i = 0; i < c_candidateCount; ++i)
+	{
+		if (candidates[i] > bestCandidate)
+			betterCount++;
+	}
+}
+
+// TRIAL returns the chosen index plus the better count, which is the checksum, and should be the same for all of them
+template <typename TRIAL>
+void CandidatesBenchmark(const TRIAL& Trial, const char* label)
+{
+	uint32_t checksum = 0;
+	double seconds = TimeSeconds([&]()
+		{
+			for (size_t trial = 0; trial < c_benchmarkCandidateTrials; ++trial)
+				checksum += (uint32_t)Trial(trial);
+		}
+	);
+
+	printf("    %s: %0.0f trials per second, %0.3f ns per candidate (checksum %u)\n", label, double(c_benchmarkCandidateTrials) / seconds,
+		1e9 * seconds / double(c_benchmarkCandidateTrials * c_candidateCount), checksum);
+}
+
+void CandidatesBenchmarks()
+{
+	size_t cutoff = size_t(float(c_candidateCount) / std::exp(1.0f));
+
+	// Whole trials, with the candidates coming from white noise
+	printf("  Trials, white noise:\n");
+	std::vector<float> candidates(c_candidateCount);
+	CandidatesBenchmark([&](size_t trial)
+		{
+			Sequence_WhiteNoise(c_candidateCount, trial).Generate(candidates.data(), c_candidateCount);
+			size_t foundAt, betterCount;
+			CandidatesThreePasses(candidates.data(), cutoff, foundAt, betterCount);
+			return foundAt + betterCount;
+		}, "Generate all, three passes"
+	);
+	CandidatesBenchmark([&](size_t trial)
+		{
+			CandidateScan scan(cutoff);
+			Sequence_WhiteNoise sequence(c_candidateCount, trial);
+			float chunk[c_candidateChunkSize];
+			for (size_t chunkStart = 0; chunkStart < c_candidateCount; chunkStart += c_candidateChunkSize)
+			{
+				size_t chunkCount = std::min(c_candidateChunkSize, c_candidateCount - chunkStart);
+				sequence.Generate(chunk, chunkCount);
+				scan.Scan(chunk, chunkCount);
+			}
+			return scan.ChosenIndex() + scan.BetterCount();
+		}, "Generate chunks, one pass"
+	);
+
+	// Just the searches, on candidates that were made ahead of time
+	printf("  Searches only:\n");
+	std::vector<float> candidateSets(c_benchmarkCandidateSets * c_candidateCount);
+	SequenceEngine<PCG32Engine>(0).Fill(candidateSets.data(), candidateSets.size());
+	CandidatesBenchmark([&](size_t trial)
+		{
+			size_t foundAt, betterCount;
+			CandidatesThreePasses(&candidateSets[(trial % c_benchmarkCandidateSets) * c_candidateCount], cutoff, foundAt, betterCount);
+			return foundAt + betterCount;
+		}, "Three passes"
+	);
+	CandidatesBenchmark([&](size_t trial)
+		{
+			CandidateScan scan(cutoff);
+			scan.Scan(&candidateSets[(trial % c_benchmarkCandidateSets) * c_candidateCount], c_candidateCount);
+			return scan.ChosenIndex() + scan.BetterCount();
+		}, "One pass"
+	);
+}
+
+static const size_t c_benchmarkSumTrials = 10000000;
+static const size_t c_benchmarkSumTrialBlockSize = 256;
+
+// TRIALS does the trials from firstTrial to firstTrial + count, and returns the sum of their counts, which is the checksum
+template <typename TRIALS>
+double SumTrialsBenchmark(const TRIALS& Trials, const char* label)
+{
+	uint64_t checksum = 0;
+	double seconds = TimeSeconds([&]()
+		{
+			for (size_t trial = 0; trial < c_benchmarkSumTrials; trial += c_benchmarkSumTrialBlockSize)
+				checksum += Trials(trial, std::min(c_benchmarkSumTrialBlockSize, c_benchmarkSumTrials - trial));
+		}
+	);
+
+	printf("  %s: %0.0f trials per second (checksum %llu)\n", label, double(c_benchmarkSumTrials) / seconds, (unsigned long long)checksum);
+	return seconds;
+}
+
+void SumTrialsBenchmarks()
+{
+	// What SumTest does, a sequence per trial, pulled from a LazySequence
+	double lazySeconds = SumTrialsBenchmark([](size_t firstTrial, size_t count)
+		{
+			uint64_t counts = 0;
+			for (size_t trial = firstTrial; trial < firstTrial + count; ++trial)
+			{
+				LazySequence<Sequence_WhiteNoiseT<PCG32Engine>> rng(25, trial);
+				float value = 0.0f;
+				while (value < 1.0f)
+				{
+					value += rng.Next();
+					counts++;
+				}
+			}
+			return counts;
+		}, "One at a time, LazySequence"
+	);
+
+	// The same trials, straight from the rngs
+	pcg32_random_t rngs[c_benchmarkSumTrialBlockSize];
+	uint32_t counts[c_benchmarkSumTrialBlockSize];
+	SumTrialsBenchmark([&](size_t firstTrial, size_t count)
+		{
+			uint64_t total = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				SeedSequenceRNG(rngs[i], firstTrial + i);
+				total += SumTrialScalar(rngs[i]);
+			}
+			return total;
+		}, "One at a time, SumTrialScalar"
+	);
+	double lanesSeconds = SumTrialsBenchmark([&](size_t firstTrial, size_t count)
+		{
+			SeedSequenceRNGs(rngs, firstTrial, count);
+			SumTrials(rngs, counts, count);
+			uint64_t total = 0;
+			for (size_t i = 0; i < count; ++i)
+				total += counts[i];
+			return total;
+		}, "SumTrials lanes"
+	);
+	// About 10x with AVX-512, and about 5x with AVX2, see SumTrials.h
+	printf("  Lanes are %0.1fx as fast as LazySequence\n", lazySeconds / lanesSeconds);
+}
+
+void RunBenchmarks()
+{
+	printf("SIMD: %s\n\n", SIMDLevelName(ActiveSIMDLevel()));
+
+	printf("Trial Setup:\n");
+	SeedingBenchmark(SeedSequenceRNG_Stream, "Stream Per Sequence");
+	SeedingBenchmark(SeedSequenceRNG_Jump, "Jump Along One Stream");
+
+	printf("\nShuffles:\n");
+	ShuffleBenchmarks();
+
+	printf("\nAppleton Blue Noise:\n");
+	AppletonBenchmark(AppletonTinyBits(SequenceEngine<PCG32Engine>(0).NextU32()), "Tiny PRNG bits");
+	AppletonBenchmark(AppletonEngineBits<PCG32Engine>(SequenceEngine<PCG32Engine>(0)), "PCG32 bits");
+	AppletonBenchmark(AppletonEngineBits<WyRandEngine>(SequenceEngine<WyRandEngine>(0)), "wyrand bits");
+	{
+		std::vector<float> samples(c_spectrumSize * c_spectrumBlockCount);
+		SequenceEngine<PCG32Engine>(0).Fill(samples.data(), samples.size());
+		printf("  White noise, for reference:\n");
+		PrintSpectrumBands(samples.data());
+	}
+
+	printf("\nCDF Tables:\n");
+	CDFBenchmarks();
+
+	printf("\nCandidates:\n");
+	CandidatesBenchmarks();
+
+	printf("\nSum Test Trials (White Noise):\n");
+	SumTrialsBenchmarks();
+
+	printf("\nEngine Throughput:\n");
+	EngineThroughputBenchmark<PCG32Engine>("PCG32");
+	EngineThroughputBenchmark<PCG64Engine>("PCG64 (pcg32x2)");
+	EngineThroughputBenchmark<PhiloxEngine>("Philox4x32-10");
+	EngineThroughputBenchmark<Xoshiro256PlusEngine>("xoshiro256+");
+	EngineThroughputBenchmark<WyRandEngine>("wyrand");
+	EngineThroughputBenchmark<SplitMix64Engine>("splitmix64");
+
+	printf("\nEngine Experiment Time (White Noise):\n\n");
+	EngineExperimentBenchmark<PCG32Engine>("PCG32");
+	EngineExperimentBenchmark<PCG64Engine>("PCG64 (pcg32x2)");
+	EngineExperimentBenchmark<PhiloxEngine>("Philox4x32-10");
+	EngineExperimentBenchmark<Xoshiro256PlusEngine>("xoshiro256+");
+	EngineExperimentBenchmark<WyRandEngine>("wyrand");
+	EngineExperimentBenchmark<SplitMix64Engine>("splitmix64");
+}
+
+void RunCutoffSweep()
+{
+	// NOTE: shuffling stratified and regular offset because they are monotonic otherwise, and the best candidate is always the last one.
+	printf("Candidate Cutoffs:\n");
+	std::vector<CutoffCurves> curves;
+	curves.push_back(CandidateCutoffSweepTest<Sequence_WhiteNoise>(0, "White Noise"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_GoldenRatio>(1, "Golden Ratio"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_StratifiedShuffled>(2, "Stratified Shuffled"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_RegularOffsetShuffled>(3, "Regular Offset Shuffled"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_RedNoise>(4, "Red Noise"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_BlueNoise>(5, "Blue Noise"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_BetterRedNoise>(6, "Better Red Noise"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_BetterBlueNoise>(7, "Better Blue Noise"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_BetterBlueNoise2>(8, "Better Blue Noise 2"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_Sqrt2>(9, "Sqrt 2"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_Plastic>(10, "Plastic"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_VanDerCorput>(11, "Van der Corput"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_Sobol>(12, "Sobol (Owen Scrambled)"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_Halton3>(13, "Halton Base 3"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_Halton5>(14, "Halton Base 5"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_BlueNoise5Tap>(15, "Blue Noise 5 Tap"));
+	curves.push_back(CandidateCutoffSweepTest<Sequence_RedNoiseIIR>(16, "Red Noise IIR"));
+
+	// A row per cutoff, with the chance of taking the best candidate, and then the average number better, for each sequence
+	std::ofstream file(c_cutoffSweepFileName);
+	file << "Cutoff";
+	for (const CutoffCurves& curve : curves)
+		file << ",\"" << curve.label << " Success\"";
+	for (const CutoffCurves& curve : curves)
+		file << ",\"" << curve.label << " Better\"";
+	file << "\n";
+	for (size_t cutoff = 1; cutoff <= c_candidateCount; ++cutoff)
+	{
+		file << cutoff;
+		for (const CutoffCurves& curve : curves)
+			file << "," << curve.success[cutoff];
+		for (const CutoffCurves& curve : curves)
+			file << "," << curve.rank[cutoff];
+		file << "\n";
+	}
+	printf("\nWrote %s\n", c_cutoffSweepFileName);
+}
+
+void RunLotteryCurves()
+{
+	printf("Lottery Lose Chance Curves:\n");
+	std::vector<LotteryCurve> curves;
+	curves.push_back(LotteryCurveTest<Sequence_WhiteNoise>(0, "White Noise"));
+	curves.push_back(LotteryCurveTest<Sequence_GoldenRatio>(1, "Golden Ratio"));
+	curves.push_back(LotteryCurveTest<Sequence_Stratified>(2, "Stratified"));
+	curves.push_back(LotteryCurveTest<Sequence_RegularOffset>(3, "Regular Offset"));
+	curves.push_back(LotteryCurveTest<Sequence_RedNoise>(4, "Red Noise"));
+	curves.push_back(LotteryCurveTest<Sequence_BlueNoise>(5, "Blue Noise"));
+	curves.push_back(LotteryCurveTest<Sequence_BetterRedNoise>(6, "Better Red Noise"));
+	curves.push_back(LotteryCurveTest<Sequence_BetterBlueNoise>(7, "Better Blue Noise"));
+	curves.push_back(LotteryCurveTest<Sequence_BetterBlueNoise2>(8, "Better Blue Noise 2"));
+	curves.push_back(LotteryCurveTest<Sequence_Sqrt2>(9, "Sqrt 2"));
+	curves.push_back(LotteryCurveTest<Sequence_Plastic>(10, "Plastic"));
+	curves.push_back(LotteryCurveTest<Sequence_VanDerCorput>(11, "Van der Corput"));
+	curves.push_back(LotteryCurveTest<Sequence_Sobol>(12, "Sobol (Owen Scrambled)"));
+	curves.push_back(LotteryCurveTest<Sequence_Halton3>(13, "Halton Base 3"));
+	curves.push_back(LotteryCurveTest<Sequence_Halton5>(14, "Halton Base 5"));
+	curves.push_back(LotteryCurveTest<Sequence_BlueNoise5Tap>(15, "Blue Noise 5 Tap"));
+	curves.push_back(LotteryCurveTest<Sequence_RedNoiseIIR>(16, "Red Noise IIR"));
+
+	// A row per number of tickets, with the lose chance for each sequence
+	std::ofstream file(c_lotteryCurveFileName);
+	file << "Tickets";
+	for (const LotteryCurve& curve : curves)
+		file << ",\"" << curve.label << "\"";
+	file << "\n";
+	for (size_t tickets = 1; tickets <= c_lotteryWinFrequency; ++tickets)
+	{
+		file << tickets;
+		for (const LotteryCurve& curve : curves)
+			file << "," << curve.loseChance[tickets];
+		file << "\n";
+	}
+	printf("\nWrote %s\n", c_lotteryCurveFileName);
+}
+
+void RunSumCurves()
+{
+	printf("Sum Curves:\n");
+	std::vector<SumCurve> curves;
+	curves.push_back(SumCurveTest<Sequence_WhiteNoise>(0, "White Noise"));
+	curves.push_back(SumCurveTest<Sequence_GoldenRatio>(1, "Golden Ratio"));
+	curves.push_back(SumCurveTest<Sequence_StratifiedShuffled>(2, "Stratified Shuffled"));
+	curves.push_back(SumCurveTest<Sequence_RegularOffsetShuffled>(3, "Regular Offset Shuffled"));
+	curves.push_back(SumCurveTest<Sequence_RedNoise>(4, "Red Noise"));
+	curves.push_back(SumCurveTest<Sequence_BlueNoise>(5, "Blue Noise"));
+	curves.push_back(SumCurveTest<Sequence_BetterRedNoise>(6, "Better Red Noise"));
+	curves.push_back(SumCurveTest<Sequence_BetterBlueNoise>(7, "Better Blue Noise"));
+	curves.push_back(SumCurveTest<Sequence_BetterBlueNoise2>(8, "Better Blue Noise 2"));
+	curves.push_back(SumCurveTest<Sequence_Sqrt2>(9, "Sqrt 2"));
+	curves.push_back(SumCurveTest<Sequence_Plastic>(10, "Plastic"));
+	curves.push_back(SumCurveTest<Sequence_VanDerCorput>(11, "Van der Corput"));
+	curves.push_back(SumCurveTest<Sequence_Sobol>(12, "Sobol (Owen Scrambled)"));
+	curves.push_back(SumCurveTest<Sequence_Halton3>(13, "Halton Base 3"));
+	curves.push_back(SumCurveTest<Sequence_Halton5>(14, "Halton Base 5"));
+	curves.push_back(SumCurveTest<Sequence_BlueNoise5Tap>(15, "Blue Noise 5 Tap"));
+	curves.push_back(SumCurveTest<Sequence_RedNoiseIIR>(16, "Red Noise IIR"));
+
+	// A row per threshold, with the white noise asymptote and then the count for each sequence
+	static const size_t c_thresholdCount = c_sumCurveMaxThreshold << c_sumCurveStepBits;
+	std::ofstream file(c_sumCurveFileName);
+	file << "Threshold,\"2t + 2/3\"";
+	for (const SumCurve& curve : curves)
+		file << ",\"" << curve.label << "\"";
+	file << "\n";
+	for (size_t threshold = 1; threshold <= c_thresholdCount; ++threshold)
+	{
+		double t = double(threshold) / double(size_t(1) << c_sumCurveStepBits);
+		file << t << "," << (2.0 * t + 2.0 / 3.0);
+		for (const SumCurve& curve : curves)
+			file << "," << curve.count[threshold];
+		file << "\n";
+	}
+	printf("\nWrote %s\n", c_sumCurveFileName);
+}
+
+// ================== CHECKS ==================
+// Checks that the fast paths give what they say they do. Each SIMD level has its own kernels, so they are checked at each.
+
+static int g_checkFailures = 0;
+
+void Check(bool ok, const char* label, const char* level = nullptr)
+{
+	if (level)
+		printf("  %s (%s): %s\n", label, level, ok ? "OK" : "FAILED");
+	else
+		printf("  %s: %s\n", label, ok ? "OK" : "FAILED");
+	if (!ok)
+		g_checkFailures++;
+}
+
+// Calls check(levelName) with each SIMD level this machine has made active, in turn
+template <typename LAMBDA>
+void CheckSIMDLevels(const LAMBDA& check)
+{
+	SIMDLevel detected = DetectSIMDLevel();
+	for (int level = 0; level <= (int)detected; ++level)
+	{
+		ActiveSIMDLevel() = (SIMDLevel)level;
+		check(SIMDLevelName((SIMDLevel)level));
+	}
+	ActiveSIMDLevel() = detected;
+}
+
+// Fills count values with fill(out, count), in uneven pieces, so that some start part way through the SIMD blocks
+template <typename T, typename FILL>
+std::vector<T> FillInPieces(size_t count, const FILL& fill)
+{
+	std::vector<T> out(count);
+	for (size_t done = 0, piece = 1; done < count; done += piece, piece = piece * 3 + 1)
+		fill(&out[done], std::min(piece, count - done));
+	return out;
+}
+
+void PCG32Checks()
+{
+	printf("PCG32 Fills:\n");
+
+	// The lanes have to make what pcg32_random_r does, in the same order, and leave the rng where it would
+	static const size_t c_count = 5000;
+	pcg32_random_t rng;
+	pcg32_srandom_r(&rng, 1, 2);
+	std::vector<uint32_t> expected(c_count + 1);
+	pcg32_random_t expectedRng = rng;
+	for (uint32_t& u : expected)
+		u = pcg32_random_r(&expectedRng);
+
+	CheckSIMDLevels([&](const char* level)
+		{
+			PCG32Engine engine(rng);
+			std::vector<uint32_t> u32s = FillInPieces<uint32_t>(c_count, [&](uint32_t* out, size_t count) { engine.Fill(out, count); });
+			bool ok = engine.NextU32() == expected[c_count];
+			for (size_t i = 0; i < c_count; ++i)
+				ok = ok && u32s[i] == expected[i];
+			Check(ok, "Fill uint32_t is pcg32_random_r", level);
+
+			engine = PCG32Engine(rng);
+			std::vector<float> floats = FillInPieces<float>(c_count, [&](float* out, size_t count) { engine.Fill(out, count); });
+			ok = engine.NextU32() == expected[c_count];
+			for (size_t i = 0; i < c_count; ++i)
+				ok = ok && floats[i] == U32ToFloat01(expected[i]);
+			Check(ok, "Fill float is U32ToFloat01(pcg32_random_r)", level);
+
+			engine = PCG32Engine(rng);
+			std::vector<uint64_t> u64s = FillInPieces<uint64_t>(c_count / 2, [&](uint64_t* out, size_t count) { engine.Fill(out, count); });
+			ok = engine.NextU32() == expected[c_count];
+			for (size_t i = 0; i < c_count / 2; ++i)
+				ok = ok && u64s[i] == ((uint64_t(expected[i * 2]) << 32) | expected[i * 2 + 1]);
+			Check(ok, "Fill uint64_t is pairs of pcg32_random_r", level);
+		}
+	);
+}
+
+void PhiloxChecks()
+{
+	printf("\nPhilox:\n");
+
+	// Known answers for Philox4x32-10, from Random123's kat_vectors
+	struct KnownAnswer
+	{
+		uint32_t counter[4];
+		uint32_t key[2];
+		uint32_t expected[4];
+	};
+	const KnownAnswer knownAnswers[] =
+	{
+		{ { 0, 0, 0, 0 }, { 0, 0 }, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+		{ { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+		{ { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+	};
+	bool ok = true;
+	for (const KnownAnswer& knownAnswer : knownAnswers)
+	{
+		uint32_t out[4];
+		Philox4x32(knownAnswer.counter, knownAnswer.key, out);
+		ok = ok && memcmp(out, knownAnswer.expected, sizeof(out)) == 0;
+	}
+	Check(ok, "Philox4x32 known answers");
+
+	// The SIMD fills have to make what PhiloxAt does, from any sample, including across the counter's low word wrapping
+	static const size_t c_count = 5000;
+	const uint64_t firstSamples[] = { 0, 3, (uint64_t(1) << 34) - 4 * 100 - 1 };
+	PhiloxKey key(0x0123456789abcdefull, 42);
+	CheckSIMDLevels([&](const char* level)
+		{
+			bool fillsOk = true;
+			for (uint64_t firstSample : firstSamples)
+			{
+				uint64_t sampleIndex = firstSample;
+				std::vector<uint32_t> u32s = FillInPieces<uint32_t>(c_count, [&](uint32_t* out, size_t count) { PhiloxFill(key, sampleIndex, out, count); sampleIndex += count; });
+				sampleIndex = firstSample;
+				std::vector<float> floats = FillInPieces<float>(c_count, [&](float* out, size_t count) { PhiloxFill(key, sampleIndex, out, count); sampleIndex += count; });
+				for (size_t i = 0; i < c_count; ++i)
+					fillsOk = fillsOk && u32s[i] == PhiloxAt(key, firstSample + i) && floats[i] == U32ToFloat01(PhiloxAt(key, firstSample + i));
+			}
+			Check(fillsOk, "PhiloxFill is PhiloxAt", level);
+		}
+	);
+}
+
+// Fill() from Seek(firstIndex) has to give what At() does for each index, for sample type T
+template <typename T, typename SEQUENCE>
+bool FillMatchesAt(SEQUENCE sequence, uint64_t firstIndex)
+{
+	static const size_t c_count = 5000;
+	sequence.Seek(firstIndex);
+	std::vector<T> actual = FillInPieces<T>(c_count, [&](T* out, size_t count) { sequence.Fill(out, count); });
+	bool ok = true;
+	for (size_t i = 0; i < c_count; ++i)
+	{
+		T expected;
+		StoreSample64(&expected, sequence.At(firstIndex + i));
+		ok = ok && actual[i] == expected;
+	}
+	return ok;
+}
+
+template <typename SEQUENCE>
+bool FillMatchesAt(const SEQUENCE& sequence, const std::vector<uint64_t>& firstIndices)
+{
+	bool ok = true;
+	for (uint64_t firstIndex : firstIndices)
+	{
+		ok = ok && FillMatchesAt<uint32_t>(sequence, firstIndex) && FillMatchesAt<float>(sequence, firstIndex);
+		ok = ok && FillMatchesAt<uint64_t>(sequence, firstIndex) && FillMatchesAt<double>(sequence, firstIndex);
+	}
+	return ok;
+}
+
+void WeylChecks()
+{
+	printf("\nWeyl Sequences, Fill() vs At():\n");
+	const std::vector<uint64_t> firstIndices = { 0, 1, 12345, (uint64_t(1) << 32) - 100, ~0ull - 1000 };
+	CheckSIMDLevels([&](const char* level)
+		{
+			Check(FillMatchesAt(KroneckerSequence<c_weylGoldenRatio>(0x0123456789abcdefull), firstIndices), "Golden ratio", level);
+			Check(FillMatchesAt(KroneckerSequence<c_weylSqrt2>(0x0123456789abcdefull), firstIndices), "Sqrt 2", level);
+			Check(FillMatchesAt(KroneckerSequence<c_weylPlastic>(0x0123456789abcdefull), firstIndices), "Plastic", level);
+		}
+	);
+}
+
+// The incremental steps, Gray code for Sobol and digit carries for Halton, against the direct formula.
+// 3^20 and 5^13 are the biggest powers of 3 and 5 under 2^32, so the Halton starts just before them carry through every digit.
+void LowDiscrepancyChecks()
+{
+	printf("\nLow Discrepancy Sequences, Fill() vs At():\n");
+	const uint64_t seed = 0x0123456789abcdefull;
+	const std::vector<uint64_t> firstIndices = { 0, 1, 12345, 3486784401ull - 100, 1220703125ull - 100, (uint64_t(1) << 32) - 100 };
+	Check(FillMatchesAt(VanDerCorputSequence(seed), firstIndices), "Van der Corput");
+	Check(FillMatchesAt(SobolSequence(seed), firstIndices), "Sobol");
+	Check(FillMatchesAt(HaltonSequence<3>(seed), firstIndices), "Halton 3");
+	Check(FillMatchesAt(HaltonSequence<5>(seed), firstIndices), "Halton 5");
+}
+
+// floor(f * numBuckets) from frexp, to check the bit twiddling in BucketFromFloat01 against
+uint32_t ExactFloatBucket(float f, uint32_t numBuckets)
+{
+	int exponent;
+	uint64_t mantissa = (uint64_t)std::ldexp(std::frexp(f, &exponent), 24);
+	int shift = 24 - exponent;
+	uint64_t bucket = (shift < 64) ? (mantissa * numBuckets) >> shift : 0;
+	return bucket < numBuckets ? (uint32_t)bucket : numBuckets - 1;
+}
+
+void BucketChecks()
+{
+	printf("\nFloat Buckets:\n");
+
+	// (1 - 2^-24) * (2^32 - 2^24 + 1) is 0xFEFFFF02 - 2^-24, which rounds up to 0xFEFFFF02 in double
+	const float justUnderOne = 1.0f - 1.0f / 16777216.0f;
+	Check(BucketFromFloat01(justUnderOne, 0xFF000001u) == 0xFEFFFF01u, "1 - 2^-24 with 2^32 - 2^24 + 1 buckets");
+
+	// Edge values, then floats from the rng, then random bit patterns in [0,1], which are mostly tiny and denormal
+	std::vector<float> in = { 0.0f, 1.0f, 0.5f, justUnderOne, 1.0f / 16777216.0f };
+	pcg32_random_t rng;
+	pcg32_srandom_r(&rng, 0, 0);
+	while (in.size() < 1000)
+		in.push_back(U32ToFloat01(pcg32_random_r(&rng)));
+	while (in.size() < 2000)
+	{
+		uint32_t bits = pcg32_random_r(&rng) % 0x3F800001;
+		float f;
+		memcpy(&f, &bits, sizeof(f));
+		in.push_back(f);
+	}
+
+	const uint32_t numBucketsList[] = { 1, 3, 1 << 16, (1 << 29) - 1, (1 << 29) + 1, 0xFF000001u, 0xFFFFFFFBu, 0xFFFFFFFFu };
+	std::vector<uint32_t> out(in.size());
+	CheckSIMDLevels([&](const char* level)
+		{
+			bool ok = true;
+			for (uint32_t numBuckets : numBucketsList)
+			{
+				Float01ToBuckets(in.data(), out.data(), in.size(), numBuckets);
+				for (size_t i = 0; i < in.size(); ++i)
+					ok = ok && out[i] == ExactFloatBucket(in[i], numBuckets);
+			}
+			Check(ok, "Float01ToBuckets is floor(f * numBuckets), up to 2^32 buckets", level);
+		}
+	);
+
+	// Out of range floats have to go where BucketFromFloat01 puts them. Over 1 the buckets can be past 32 bits before the clamp.
+	std::vector<float> outOfRange = { 1.0f + 1.0f / 8388608.0f, 1.5f, 2.0f, 255.75f, 65537.0f, 1e7f, 16777216.0f, 1e30f,
+		-0.5f, -2.0f, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN() };
+	while (outOfRange.size() < 100)
+		outOfRange.push_back(1.0f + float(outOfRange.size()) * 1000.25f);
+	out.resize(outOfRange.size());
+	CheckSIMDLevels([&](const char* level)
+		{
+			bool ok = true;
+			for (uint32_t numBuckets : numBucketsList)
+			{
+				Float01ToBuckets(outOfRange.data(), out.data(), outOfRange.size(), numBuckets);
+				for (size_t i = 0; i < outOfRange.size(); ++i)
+					ok = ok && out[i] == BucketFromFloat01(outOfRange[i], numBuckets);
+			}
+			Check(ok, "Float01ToBuckets is BucketFromFloat01 outside of [0,1]", level);
+		}
+	);
+}
+
+void PermutationChecks()
+{
+	printf("\nFeistel Permutation:\n");
+
+	// Where each element lands, over many seeds, should be uniform. The chi squared statistic, summed over the elements,
+	// has n(n-1) degrees of freedom (a few less, since each seed is a permutation), so is within 5 sd of that if so.
+	// 4 rounds, or halves of 1 or 2 bits, put some elements in some places up to 10% too often, which is well past that.
+	static const size_t c_seedCount = 100000;
+	const size_t nList[] = { 2, 3, 4, 5, 7, 16, 33, 64, 65, 127, 130 };
+	bool ok = true;
+	for (size_t n : nList)
+	{
+		std::vector<size_t> counts(n * n, 0);
+		for (size_t seed = 0; seed < c_seedCount; ++seed)
+		{
+			FeistelPermutation permutation(n, seed);
+			for (size_t i = 0; i < n; ++i)
+				counts[i * n + permutation.At(i)]++;
+		}
+		double expected = double(c_seedCount) / double(n);
+		double chiSquared = 0.0;
+		for (size_t count : counts)
+			chiSquared += (double(count) - expected) * (double(count) - expected) / expected;
+		double degreesOfFreedom = double(n * (n - 1));
+		ok = ok && chiSquared < degreesOfFreedom + 5.0 * std::sqrt(2.0 * degreesOfFreedom);
+	}
+	Check(ok, "Positions pass chi squared, n = 2 to 130");
+
+	std::vector<float> values(100);
+	Sequence_StratifiedPermutedT<WhiteNoiseEngine>(0, 0).Generate(values.data(), values.size());
+	Check(std::all_of(values.begin(), values.end(), [](float f) { return f >= 0.0f && f <= 1.0f; }), "Stratified permuted with 0 samples is in [0,1]");
+	Sequence_Shuffled<Sequence_Stratified>(0, 0).Generate(values.data(), values.size());
+	Check(std::all_of(values.begin(), values.end(), [](float f) { return f >= 0.0f && f <= 1.0f; }), "Stratified shuffled with 0 samples is in [0,1]");
+}
+
+// NextN() has to give the same bits as calling Next() that many times, at every SIMD level and whatever the compiler flags
+template <typename STREAM>
+void StreamCheck(const STREAM& stream, const char* label)
+{
+	static const size_t c_count = 5000;
+	CheckSIMDLevels([&](const char* level)
+		{
+			STREAM one = stream;
+			std::vector<float> expected(c_count);
+			for (float& f : expected)
+				f = one.Next();
+
+			// Uneven pieces, so some start part way through the stream's blocks
+			STREAM many = stream;
+			std::vector<float> actual(c_count);
+			for (size_t done = 0, piece = 1; done < c_count; done += piece, piece = piece * 3 + 1)
+				many.NextN(&actual[done], std::min(piece, c_count - done));
+
+			Check(memcmp(expected.data(), actual.data(), c_count * sizeof(float)) == 0, label, level);
+		}
+	);
+}
+
+// Discard(n) has to leave the stream where n calls to Next() would. MAKE(seed) makes a stream.
+template <typename MAKE>
+void DiscardCheck(const MAKE& Make, const char* label)
+{
+	bool ok = true;
+	for (uint64_t count : { 0, 1, 31, 63, 64, 129, 200, 1000, 4097, 100000 })
+	{
+		for (uint64_t seed = 0; seed < 100; ++seed)
+		{
+			auto stepped = Make(seed);
+			auto discarded = stepped;
+			for (uint64_t i = 0; i < count; ++i)
+				stepped.Next();
+			discarded.Discard(count);
+			for (int i = 0; i < 100; ++i)
+				ok = ok && stepped.Next() == discarded.Next();
+		}
+	}
+	Check(ok, label);
+}
+
+template <typename T>
+void AppletonDiscardCheck(const char* label)
+{
+	typedef BlueNoiseStreamAppletonT<T, AppletonEngineBits<PCG32Engine>> Stream;
+	DiscardCheck([](uint64_t seed) { return Stream(AppletonEngineBits<PCG32Engine>(PCG32Engine(seed, 1))); }, label);
+}
+
+template <typename FILTER, typename T>
+void FilteredNoiseDiscardCheck(const char* label)
+{
+	DiscardCheck([](uint64_t seed) { return FilteredNoiseStreamT<PCG32Engine, FILTER, T>(PCG32Engine(seed, 1)); }, label);
+}
+
+// Filters for the Discard checks: a pole near 1, which forgets slowly, and a negative tap, which flips the bounds
+struct SlowRedNoiseFilterIIR
+{
+	static const int c_xTapCount = 1;
+	static const int c_yTapCount = 1;
+	static const float* XTaps() { static const float taps[c_xTapCount] = { 0.01f }; return taps; }
+	static const float* YTaps() { static const float taps[c_yTapCount] = { 0.99f }; return taps; }
+	static const NoiseCDF& CDF() { return FittedNoiseCDF<SlowRedNoiseFilterIIR>(); }
+};
+
+struct RingingNoiseFilterIIR
+{
+	static const int c_xTapCount = 2;
+	static const int c_yTapCount = 2;
+	static const float* XTaps() { static const float taps[c_xTapCount] = { 0.5f, 0.25f }; return taps; }
+	static const float* YTaps() { static const float taps[c_yTapCount] = { 0.6f, -0.3f }; return taps; }
+	static const NoiseCDF& CDF() { return FittedNoiseCDF<RingingNoiseFilterIIR>(); }
+};
+
+// The filtered noise sequences, made of pipeline stages, have to give the same values as FilteredNoiseStreamT
+template <typename FILTER, typename T>
+void FilteredNoisePipelineCheck(const char* label)
+{
+	static const size_t c_count = 5000;
+	CheckSIMDLevels([&](const char* level)
+		{
+			bool ok = true;
+			for (uint64_t sequenceIndex = 0; sequenceIndex < 10; ++sequenceIndex)
+			{
+				std::vector<T> expected(c_count);
+				FilteredNoiseStreamT<WhiteNoiseEngine, FILTER, T, CDF_TABLE_SIZE()>(SequenceEngine<WhiteNoiseEngine>(sequenceIndex)).NextN(expected.data(), c_count);
+				Sequence_FilteredNoiseT<WhiteNoiseEngine, FILTER, T> sequence(c_count, sequenceIndex);
+				ok = ok && FillInPieces<T>(c_count, [&](T* out, size_t count) { sequence.Generate(out, count); }) == expected;
+			}
+			Check(ok, label, level);
+		}
+	);
+}
+
+void PipelineChecks()
+{
+	printf("\nFiltered Noise, Pipeline vs Stream:\n");
+	FilteredNoisePipelineCheck<BlueNoiseFilter, float>("Blue noise");
+	FilteredNoisePipelineCheck<RedNoiseFilter, float>("Red noise");
+	FilteredNoisePipelineCheck<BlueNoiseFilter5, float>("Blue noise 5 tap");
+	FilteredNoisePipelineCheck<RedNoiseFilterIIR, float>("Red noise IIR, float");
+	FilteredNoisePipelineCheck<RedNoiseFilterIIR, double>("Red noise IIR, double");
+	FilteredNoisePipelineCheck<SlowRedNoiseFilterIIR, float>("Pole at 0.99");
+	FilteredNoisePipelineCheck<RingingNoiseFilterIIR, float>("Negative tap");
+}
+
+void StreamChecks()
+{
+	printf("\nStreams, Next() vs NextN():\n");
+	StreamCheck(BlueNoiseStreamPolynomial(PCG32Engine(1, 2)), "Blue noise polynomial");
+	StreamCheck(RedNoiseStreamPolynomial(PCG32Engine(1, 2)), "Red noise polynomial");
+	StreamCheck(FilteredNoiseStreamT<PCG32Engine, BlueNoiseFilter5>(PCG32Engine(1, 2)), "Blue noise 5 tap");
+	StreamCheck(FilteredNoiseStreamT<PCG32Engine, RedNoiseFilterIIR>(PCG32Engine(1, 2)), "Red noise IIR");
+	StreamCheck(FilteredNoiseStreamT<PCG32Engine, BlueNoiseFilter5, float, 1024>(PCG32Engine(1, 2)), "Blue noise 5 tap, CDF table");
+	StreamCheck(BlueNoiseStreamAppletonT<float, AppletonEngineBits<PCG32Engine>>(AppletonEngineBits<PCG32Engine>(PCG32Engine(1, 2))), "Appleton");
+
+	printf("\nStreams, Discard() vs Next():\n");
+	AppletonDiscardCheck<float>("Appleton, float");
+	AppletonDiscardCheck<double>("Appleton, double");
+	FilteredNoiseDiscardCheck<BlueNoiseFilter5, float>("Blue noise 5 tap, float");
+	FilteredNoiseDiscardCheck<RedNoiseFilterIIR, float>("Red noise IIR, float");
+	FilteredNoiseDiscardCheck<RedNoiseFilterIIR, double>("Red noise IIR, double");
+	FilteredNoiseDiscardCheck<SlowRedNoiseFilterIIR, float>("Pole at 0.99, float");
+	FilteredNoiseDiscardCheck<SlowRedNoiseFilterIIR, double>("Pole at 0.99, double");
+	FilteredNoiseDiscardCheck<RingingNoiseFilterIIR, float>("Negative tap, float");
+}
+
+// The CDF fits have to go through 0 and 1 at the ends, and join up where the pieces meet, give or take float rounding
+template <typename FILTER>
+void NoiseCDFCheck(const char* label)
+{
+	const NoiseCDF& cdf = FILTER::CDF();
+	bool ok = std::abs(EvaluateNoiseCDFPolynomial(cdf, 0.0)) < 1e-5 && std::abs(EvaluateNoiseCDFPolynomial(cdf, 1.0) - 1.0) < 1e-5;
+	for (int piece = 1; piece < cdf.pieceCount; ++piece)
+	{
+		double x = double(piece) / double(cdf.pieceCount);
+		const float* left = &cdf.polynomials[(piece - 1) * 4];
+		const float* right = &cdf.polynomials[piece * 4];
+		double leftValue = ((left[0] * x + left[1]) * x + left[2]) * x + left[3];
+		double rightValue = ((right[0] * x + right[1]) * x + right[2]) * x + right[3];
+		ok = ok && std::abs(leftValue - rightValue) < 1e-5;
+	}
+	Check(ok, (std::string(label) + ", CDF fit ends at 0 and 1, and its pieces join").c_str());
+
+	// What the stream makes has to be in [0,1), like white noise, including the first sample, before the filter has history
+	CheckSIMDLevels([&](const char* level)
+		{
+			std::vector<float> values(1 << 20);
+			FilteredNoiseStreamT<PCG32Engine, FILTER>(PCG32Engine(1, 2)).NextN(values.data(), values.size());
+			for (uint64_t sequenceIndex = 0; sequenceIndex < 10000; ++sequenceIndex)
+				values.push_back(FilteredNoiseStreamT<PCG32Engine, FILTER>(PCG32Engine(1, sequenceIndex)).Next());
+			bool inRange = std::all_of(values.begin(), values.end(), [](float f) { return f >= 0.0f && f < 1.0f; });
+			Check(inRange, (std::string(label) + ", output is in [0,1)").c_str(), level);
+		}
+	);
+}
+
+void NoiseCDFChecks()
+{
+	printf("\nNoise CDFs:\n");
+	NoiseCDFCheck<BlueNoiseFilter>("Blue noise");
+	NoiseCDFCheck<RedNoiseFilter>("Red noise");
+	NoiseCDFCheck<BlueNoiseFilter5>("Blue noise 5 tap");
+	NoiseCDFCheck<RedNoiseFilterIIR>("Red noise IIR");
+}
+
+void PrefixSumChecks()
+{
+	printf("\nPrefix Sums:\n");
+
+	// Values of 0 and below, mixed in with [0,1] ones, have to add 0, not wrap around to a huge sum
+	std::vector<float> in;
+	pcg32_random_t rng;
+	pcg32_srandom_r(&rng, 0, 0);
+	for (int i = 0; i < 37; ++i)
+	{
+		float bad[] = { -1e-5f, -0.0f, 0.0f, -1.0f, std::numeric_limits<float>::quiet_NaN() };
+		in.push_back((i % 3 == 0) ? bad[(i / 3) % 5] : U32ToFloat01(pcg32_random_r(&rng)));
+	}
+
+	std::vector<uint64_t> expected(in.size());
+	double sum = 0.0;
+	for (size_t i = 0; i < in.size(); ++i)
+	{
+		if (in[i] > 0.0f)
+			sum += std::nearbyint(double(in[i]) * double(uint64_t(1) << c_prefixSumFractionBits));
+		expected[i] = uint64_t(sum);
+	}
+
+	std::vector<uint64_t> out(in.size());
+	CheckSIMDLevels([&](const char* level)
+		{
+			uint64_t total = PrefixSums(in.data(), out.data(), in.size(), 0);
+			Check(out == expected && total == expected.back(), "Values of 0 and below add 0", level);
+		}
+	);
+}
+
+// Candidates with lots of ties, and runs of them: white noise rounded to a few levels, some of which are 0
+std::vector<float> CheckCandidates(size_t count, uint64_t seed)
+{
+	pcg32_random_t rng;
+	pcg32_srandom_r(&rng, seed, 3);
+	uint32_t levels = 2 + pcg32_random_r(&rng) % 30;
+	std::vector<float> candidates(count);
+	for (float& candidate : candidates)
+		candidate = float(pcg32_random_r(&rng) % levels) / float(levels - 1);
+	return candidates;
+}
+
+// The secretary problem, as three separate passes over the candidates, the way it reads
+void CandidatesThreePassReference(const std::vector<float>& candidates, size_t cutoff, bool& found, size_t& chosenIndex, size_t& betterCount)
+{
+	float bestBeforeCutoff = 0.0f;
+	for (size_t i = 0; i < cutoff; ++i)
+		bestBeforeCutoff = std::max(bestBeforeCutoff, candidates[i]);
+
+	found = false;
+	chosenIndex = candidates.size() - 1;
+	for (size_t i = cutoff; i < candidates.size() && !found; ++i)
+	{
+		found = candidates[i] > bestBeforeCutoff;
+		chosenIndex = found ? i : chosenIndex;
+	}
+
+	betterCount = 0;
+	for (float candidate : candidates)
+		betterCount += (found && candidate > candidates[chosenIndex]) ? 1 : 0;
+}
+
+void CandidateScanChecks()
+{
+	printf("\nCandidate Scan:\n");
+
+	// Counts around the SIMD block sizes, every cutoff, and the candidates scanned in uneven pieces
+	const size_t counts[] = { 1, 2, 7, 8, 9, 15, 16, 17, 31, 32, 33, 64, 100, 257 };
+	CheckSIMDLevels([&](const char* level)
+		{
+			bool ok = true;
+			for (size_t count : counts)
+			{
+				for (uint64_t seed = 0; seed < 20; ++seed)
+				{
+					std::vector<float> candidates = CheckCandidates(count, seed);
+					for (size_t cutoff = 0; cutoff <= count; ++cutoff)
+					{
+						bool found;
+						size_t chosenIndex, betterCount;
+						CandidatesThreePassReference(candidates, cutoff, found, chosenIndex, betterCount);
+
+						CandidateScan scan(cutoff);
+						for (size_t done = 0, piece = 1 + seed % 5; done < count; done += piece, piece = piece * 3 + 1)
+							scan.Scan(&candidates[done], std::min(piece, count - done));
+						ok = ok && scan.ChosenIndex() == chosenIndex && scan.BetterCount() == betterCount;
+					}
+				}
+			}
+			Check(ok, "CandidateScan is the three pass search, with ties", level);
+		}
+	);
+}
+
+// The sweep has to give what a CandidateScan per cutoff does. Except when nothing after the cutoff beats the ones before it,
+// where the sweep ranks the last candidate as itself, and doesn't count it as a success.
+void CandidateCutoffSweepChecks()
+{
+	printf("\nCandidate Cutoff Sweep:\n");
+	const size_t counts[] = { 1, 2, 7, 8, 9, 15, 16, 17, 31, 32, 33, 64, 100, 257 };
+	CheckSIMDLevels([&](const char* level)
+		{
+			bool ok = true;
+			CandidateCutoffSweep sweep;
+			for (size_t count : counts)
+			{
+				for (uint64_t seed = 0; seed < 20; ++seed)
+				{
+					std::vector<float> candidates = CheckCandidates(count, seed);
+					std::vector<uint64_t> successes(count + 1, 0);
+					std::vector<uint64_t> betterCounts(count + 1, 0);
+					sweep.Add(candidates.data(), count, successes.data(), betterCounts.data());
+
+					for (size_t cutoff = 1; cutoff <= count; ++cutoff)
+					{
+						CandidateScan scan(cutoff);
+						scan.Scan(candidates.data(), count);
+						float bestBeforeCutoff = *std::max_element(candidates.begin(), candidates.begin() + cutoff);
+						bool found = std::any_of(candidates.begin() + cutoff, candidates.end(), [&](float f) { return f > bestBeforeCutoff; });
+						uint64_t betterCount = found ? scan.BetterCount() : CountBetterCandidates(candidates.data(), count, candidates[count - 1]);
+						ok = ok && betterCounts[cutoff] == betterCount && successes[cutoff] == ((found && betterCount == 0) ? 1u : 0u);
+					}
+				}
+			}
+			Check(ok, "CandidateCutoffSweep is a CandidateScan per cutoff, with ties", level);
+		}
+	);
+}
+
+void SumTrialsChecks()
+{
+	printf("\nSum Test Trials:\n");
+
+	// What SumTest gets from the white noise sequences. 1000 isn't a multiple of 16 or 8, so the scalar tail runs too.
+	static const size_t c_count = 1000;
+	static const uint64_t c_firstSequenceIndex = 12345;
+	std::vector<uint32_t> expected(c_count);
+	size_t expectedGenerated = 0;
+	for (size_t i = 0; i < c_count; ++i)
+	{
+		LazySequence<Sequence_WhiteNoiseT<PCG32Engine>> sequence(25, c_firstSequenceIndex + i);
+		float value = 0.0f;
+		while (value < 1.0f)
+		{
+			value += sequence.Next();
+			expected[i]++;
+		}
+		expectedGenerated += expected[i];
+	}
+
+	CheckSIMDLevels([&](const char* level)
+		{
+			std::vector<pcg32_random_t> rngs(c_count);
+			SeedSequenceRNGs(rngs.data(), c_firstSequenceIndex, c_count);
+			std::vector<uint32_t> scalarCounts(c_count);
+			for (size_t i = 0; i < c_count; ++i)
+				scalarCounts[i] = SumTrialScalar(rngs[i]);
+			Check(scalarCounts == expected, "SumTrialScalar is SumTest on white noise", level);
+
+			std::vector<uint32_t> counts(c_count);
+			size_t generated = SumTrials(rngs.data(), counts.data(), c_count);
+			Check(counts == expected && generated >= expectedGenerated, "SumTrials is SumTrialScalar", level);
+		}
+	);
+}
+
+int RunChecks()
+{
+	PCG32Checks();
+	PhiloxChecks();
+	BucketChecks();
+	WeylChecks();
+	LowDiscrepancyChecks();
+	PermutationChecks();
+	StreamChecks();
+	PipelineChecks();
+	NoiseCDFChecks();
+	CandidateScanChecks();
+	CandidateCutoffSweepChecks();
+	PrefixSumChecks();
+	SumTrialsChecks();
+
+	printf("\n%i checks failed\n", g_checkFailures);
+	return g_checkFailures;
+}
+
+int main(int argc, char** argv)
+{
+#if !DETERMINISTIC()
+	std::random_device rd;
+	g_randomSeed = rd();
+#endif
+	g_sequenceJumper.Init(g_randomSeed);
+
+#if RUN_BENCHMARKS()
+	RunBenchmarks();
+	return 0;
+#endif
+
+#if RUN_CUTOFF_SWEEP()
+	RunCutoffSweep();
+	return 0;
+#endif
+
+#if RUN_LOTTERY_CURVES()
+	RunLotteryCurves();
+	return 0;
+#endif
+
+#if RUN_SUM_CURVES()
+	RunSumCurves();
+	return 0;
+#endif
+
+#if RUN_CHECKS()
+	return RunChecks();
+#endif
+
+	printf("e = %f\n", std::exp(1.0f));
+	printf("1/e = %f\n\n", 1.0f / std::exp(1.0f));
+
+	// NOTE: more evenly spaced sampling means fewer duplicates, which is why they win more.
+	printf("Lottery Lose Chance:\n");
+	LotteryTests<Sequence_WhiteNoise>(0, "White Noise");
+	LotteryTests<Sequence_GoldenRatio>(1, "Golden Ratio");
+	LotteryTests<Sequence_Stratified>(2, "Stratified");
+	LotteryTests<Sequence_RegularOffset>(3, "Regular Offset");
+	LotteryTests<Sequence_RedNoise>(4, "Red Noise");
+	LotteryTests<Sequence_BlueNoise>(5, "Blue Noise");
+	LotteryTests<Sequence_BetterRedNoise>(6, "Better Red Noise");
+	LotteryTests<Sequence_BetterBlueNoise>(7, "Better Blue Noise");
+	LotteryTests<Sequence_BetterBlueNoise2>(8, "Better Blue Noise 2");
+	LotteryTests<Sequence_Sqrt2>(9, "Sqrt 2");
+	LotteryTests<Sequence_Plastic>(10, "Plastic");
+	LotteryTests<Sequence_VanDerCorput>(11, "Van der Corput");
+	LotteryTests<Sequence_Sobol>(12, "Sobol (Owen Scrambled)");
+	LotteryTests<Sequence_Halton3>(13, "Halton Base 3");
+	LotteryTests<Sequence_Halton5>(14, "Halton Base 5");
+	LotteryTests<Sequence_BlueNoise5Tap>(15, "Blue Noise 5 Tap");
+	LotteryTests<Sequence_RedNoiseIIR>(16, "Red Noise IIR");
+
+	// NOTE: shuffling stratified and regular offset cause they are only appropriate when we know the number of samples in advance. we don't for this test.
+	printf("\nSumming Random Values:\n");
+#if SUM_TEST_LANES()
+	SumTestLanes(0, "White Noise");
+#else
+	SumTest<Sequence_WhiteNoise>(0, "White Noise");
+#endif
+	SumTest<Sequence_GoldenRatio>(1, "Golden Ratio");
+	SumTest<Sequence_StratifiedShuffled>(2, "Stratified Shuffled");
+	SumTest<Sequence_RegularOffsetShuffled>(3, "Regular Offset Shuffled");
+	SumTest<Sequence_RedNoise>(4, "Red Noise");
+	SumTest<Sequence_BlueNoise>(5, "Blue Noise");
+	SumTest<Sequence_BetterRedNoise>(6, "Better Red Noise");
+	SumTest<Sequence_BetterBlueNoise>(7, "Better Blue Noise");
+	SumTest<Sequence_BetterBlueNoise2>(8, "Better Blue Noise 2");
+	SumTest<Sequence_Sqrt2>(9, "Sqrt 2");
+	SumTest<Sequence_Plastic>(10, "Plastic");
+	SumTest<Sequence_VanDerCorput>(11, "Van der Corput");
+	SumTest<Sequence_Sobol>(12, "Sobol (Owen Scrambled)");
+	SumTest<Sequence_Halton3>(13, "Halton Base 3");
+	SumTest<Sequence_Halton5>(14, "Halton Base 5");
+	SumTest<Sequence_BlueNoise5Tap>(15, "Blue Noise 5 Tap");
+	SumTest<Sequence_RedNoiseIIR>(16, "Red Noise IIR");
 
 	// NOTE: shuffling stratified and regular offset because they are monotonic otherwise, and the best candidate is always the last one.
 	printf("\nCandidates:\n");
-	CandidatesTest(Generate_WhiteNoise, 0, "White Noise");
-	CandidatesTest(Generate_GoldenRatio, 1, "Golden Ratio");
-	CandidatesTest(Generate_StratifiedShuffled, 2, "Stratified Shuffled");
-	CandidatesTest(Generate_RegularOffsetShuffled, 3, "Regular Offset Shuffled");
-	CandidatesTest(Generate_RedNoise, 4, "Red Noise");
-	CandidatesTest(Generate_BlueNoise, 5, "Blue Noise");
-	CandidatesTest(Generate_BetterRedNoise, 6, "Better Red Noise");
-	CandidatesTest(Generate_BetterBlueNoise, 7, "Better Blue Noise");
-	CandidatesTest(Generate_BetterBlueNoise2, 8, "Better Blue Noise 2");
+	CandidatesTest<Sequence_WhiteNoise>(0, "White Noise");
+	CandidatesTest<Sequence_GoldenRatio>(1, "Golden Ratio");
+	CandidatesTest<Sequence_StratifiedShuffled>(2, "Stratified Shuffled");
+	CandidatesTest<Sequence_RegularOffsetShuffled>(3, "Regular Offset Shuffled");
+	CandidatesTest<Sequence_RedNoise>(4, "Red Noise");
+	CandidatesTest<Sequence_BlueNoise>(5, "Blue Noise");
+	CandidatesTest<Sequence_BetterRedNoise>(6, "Better Red Noise");
+	CandidatesTest<Sequence_BetterBlueNoise>(7, "Better Blue Noise");
+	CandidatesTest<Sequence_BetterBlueNoise2>(8, "Better Blue Noise 2");
+	CandidatesTest<Sequence_Sqrt2>(9, "Sqrt 2");
+	CandidatesTest<Sequence_Plastic>(10, "Plastic");
+	CandidatesTest<Sequence_VanDerCorput>(11, "Van der Corput");
+	CandidatesTest<Sequence_Sobol>(12, "Sobol (Owen Scrambled)");
+	CandidatesTest<Sequence_Halton3>(13, "Halton Base 3");
+	CandidatesTest<Sequence_Halton5>(14, "Halton Base 5");
+	CandidatesTest<Sequence_BlueNoise5Tap>(15, "Blue Noise 5 Tap");
+	CandidatesTest<Sequence_RedNoiseIIR>(16, "Red Noise IIR");
 
 	return 0;
 }
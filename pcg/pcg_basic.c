@@ -72,6 +72,62 @@ uint32_t pcg32_random()
 }
 
 
+// pcg_advance_lcg_64(state, delta, cur_mult, cur_plus):
+//     Multi-step advance of any 64-bit LCG.
+//
+// The method used here is based on Brown, "Random Number Generation
+// with Arbitrary Stride,", Transactions of the American Nuclear
+// Society (Nov. 1994).  The algorithm is very similar to fast
+// exponentiation.
+//
+// Even though delta is an unsigned integer, we can pass a signed
+// integer to go backwards, it just goes "the long way round".
+
+uint64_t pcg_advance_lcg_64(uint64_t state, uint64_t delta, uint64_t cur_mult,
+                            uint64_t cur_plus)
+{
+    uint64_t acc_mult = 1u;
+    uint64_t acc_plus = 0u;
+    while (delta > 0) {
+        if (delta & 1) {
+            acc_mult *= cur_mult;
+            acc_plus = acc_plus * cur_mult + cur_plus;
+        }
+        cur_plus = (cur_mult + 1) * cur_plus;
+        cur_mult *= cur_mult;
+        delta /= 2;
+    }
+    return acc_mult * state + acc_plus;
+}
+
+// pcg32_advance(delta)
+// pcg32_advance_r(rng, delta)
+// pcg32_backstep(delta)
+// pcg32_backstep_r(rng, delta):
+//     Multi-step advance functions (jump-ahead, jump-back)
+
+void pcg32_advance_r(pcg32_random_t* rng, uint64_t delta)
+{
+    rng->state = pcg_advance_lcg_64(rng->state, delta,
+                                    6364136223846793005ULL, rng->inc);
+}
+
+void pcg32_advance(uint64_t delta)
+{
+    pcg32_advance_r(&pcg32_global, delta);
+}
+
+void pcg32_backstep_r(pcg32_random_t* rng, uint64_t delta)
+{
+    // The period is 2^64, so going back delta is going forward 2^64 - delta
+    pcg32_advance_r(rng, ~delta + 1u);
+}
+
+void pcg32_backstep(uint64_t delta)
+{
+    pcg32_backstep_r(&pcg32_global, delta);
+}
+
 // pcg32_boundedrand(bound):
 // pcg32_boundedrand_r(rng, bound):
 //     Generate a uniformly distributed number, r, where 0 <= r < bound
@@ -64,6 +64,25 @@ void pcg32_srandom_r(pcg32_random_t* rng, uint64_t initstate,
 uint32_t pcg32_random(void);
 uint32_t pcg32_random_r(pcg32_random_t* rng);
 
+// pcg32_advance(delta)
+// pcg32_advance_r(rng, delta)
+// pcg32_backstep(delta)
+// pcg32_backstep_r(rng, delta):
+//     Multi-step advance functions (jump-ahead, jump-back), in O(log delta)
+
+void pcg32_advance(uint64_t delta);
+void pcg32_advance_r(pcg32_random_t* rng, uint64_t delta);
+void pcg32_backstep(uint64_t delta);
+void pcg32_backstep_r(pcg32_random_t* rng, uint64_t delta);
+
+// pcg_advance_lcg_64(state, delta, cur_mult, cur_plus):
+//     Applies the LCG step state = state * cur_mult + cur_plus, delta times.
+//     The building block of advance, exposed so callers can jump in strides
+//     other than one step.
+
+uint64_t pcg_advance_lcg_64(uint64_t state, uint64_t delta, uint64_t cur_mult,
+                            uint64_t cur_plus);
+
 // pcg32_boundedrand(bound):
 // pcg32_boundedrand_r(rng, bound):
 //     Generate a uniformly distributed number, r, where 0 <= r < bound